@@ -2,11 +2,19 @@
 
 #include <raymath.h>
 
+#include "MathUtils.h"
+#include "StateStream.h"
+
+// Floating point error slowly pulls rotations away from unit length. They're only normalized
+// again once they've drifted this far, which takes many ticks.
+static const float RenormalizeTolerance = 1e-5f;
+
 Actor::Actor()
 {
 	Position = Vector3Zero();
 	Velocity = Vector3Zero();
 	Rotation = QuaternionIdentity();
+	AngularVelocity = Vector3Zero();
 }
 
 Vector3 Actor::GetForward() const
@@ -66,3 +74,49 @@ void Actor::RotateLocalEuler(Vector3 axis, float degrees)
 		Rotation,
 		QuaternionFromAxisAngle(axis, radians));
 }
+
+static Quaternion IntegrateRotationStep(Quaternion rotation, Vector3 angularVelocity, float deltaTime)
+{
+	// Angular velocity is in local space, so the step is applied on the right.
+	auto step = QuaternionFromRotationVector(Vector3Scale(angularVelocity, deltaTime));
+	rotation = QuaternionMultiply(rotation, step);
+
+	float lengthSquared = rotation.x * rotation.x + rotation.y * rotation.y
+		+ rotation.z * rotation.z + rotation.w * rotation.w;
+	if (fabsf(lengthSquared - 1.0f) > RenormalizeTolerance)
+	{
+		float inverseLength = 1.0f / sqrtf(lengthSquared);
+		rotation = { rotation.x * inverseLength, rotation.y * inverseLength,
+			rotation.z * inverseLength, rotation.w * inverseLength };
+	}
+
+	return rotation;
+}
+
+void Actor::IntegrateRotation(float deltaTime)
+{
+	Rotation = IntegrateRotationStep(Rotation, AngularVelocity, deltaTime);
+}
+
+void Actor::IntegrateRotations(Actor* const* actors, int count, float deltaTime)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		Actor& actor = *actors[i];
+		actor.Rotation = IntegrateRotationStep(actor.Rotation, actor.AngularVelocity, deltaTime);
+	}
+}
+
+void Actor::WriteState(StateWriter& writer) const
+{
+	writer.Write(Position);
+	writer.Write(Velocity);
+	writer.Write(Rotation);
+}
+
+void Actor::ReadState(StateReader& reader)
+{
+	reader.Read(Position);
+	reader.Read(Velocity);
+	reader.Read(Rotation);
+}
@@ -2,6 +2,9 @@
 
 #include <raylib.h>
 
+class StateReader;
+class StateWriter;
+
 class Actor
 {
 public:
@@ -11,6 +14,9 @@ public:
 	Vector3 Velocity;
 	Quaternion Rotation;
 
+	// Radians per second around the actor's own x (left), y (up) and z (forward) axes.
+	Vector3 AngularVelocity;
+
 	Vector3 GetForward() const;
 	Vector3 GetBack() const;
 	Vector3 GetRight() const;
@@ -20,4 +26,18 @@ public:
 
 	Vector3 TransformPoint(Vector3 point) const;
 	void RotateLocalEuler(Vector3 axis, float degrees);
+
+	/// <summary>
+	/// Turns the actor by its AngularVelocity over deltaTime. All three axes are applied together
+	/// in one step rather than one after the other.
+	/// </summary>
+	void IntegrateRotation(float deltaTime);
+
+	/// <summary>
+	/// Same as IntegrateRotation, for every actor in the array in one pass.
+	/// </summary>
+	static void IntegrateRotations(Actor* const* actors, int count, float deltaTime);
+
+	void WriteState(StateWriter& writer) const;
+	void ReadState(StateReader& reader);
 };
@@ -0,0 +1,246 @@
+#include "AllocationTracker.h"
+
+#include <raylib.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static const int SubsystemCount = (int)Subsystem::Count;
+
+static thread_local Subsystem CurrentSubsystem = Subsystem::Startup;
+
+static std::atomic<unsigned int> AllocationCounts[SubsystemCount];
+static std::atomic<unsigned long long> ByteCounts[SubsystemCount];
+
+// Only touched by the thread calling EndFrame().
+static AllocationStats LastFrame[SubsystemCount];
+static bool IsSteadyState = false;
+static bool HasSteadyStateAllocations = false;
+static bool HasWarned[SubsystemCount];
+
+static void CountAllocation(size_t size)
+{
+	int subsystem = (int)CurrentSubsystem;
+	AllocationCounts[subsystem].fetch_add(1, std::memory_order_relaxed);
+	ByteCounts[subsystem].fetch_add(size, std::memory_order_relaxed);
+}
+
+static void* TrackedAllocate(size_t size)
+{
+	// malloc(0) may legally return nullptr, which operator new isn't allowed to.
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory != nullptr)
+		CountAllocation(size);
+	return memory;
+}
+
+static void* TrackedAllocateAligned(size_t size, std::align_val_t alignment)
+{
+	size_t align = (size_t)alignment;
+	size_t allocated = size > 0 ? size : 1;
+
+#if defined(_MSC_VER)
+	void* memory = _aligned_malloc(allocated, align);
+#else
+	// aligned_alloc() needs the size to be a multiple of the alignment.
+	allocated = (allocated + align - 1) / align * align;
+	void* memory = aligned_alloc(align, allocated);
+#endif
+
+	if (memory != nullptr)
+		CountAllocation(size);
+	return memory;
+}
+
+// Memory from _aligned_malloc() can't be given to free().
+static void FreeAligned(void* memory)
+{
+#if defined(_MSC_VER)
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+void* operator new(size_t size)
+{
+	void* memory = TrackedAllocate(size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	void* memory = TrackedAllocate(size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* memory = TrackedAllocateAligned(size, alignment);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	void* memory = TrackedAllocateAligned(size, alignment);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocateAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(memory);
+}
+
+void AllocationTracker::EndFrame()
+{
+	for (int i = 0; i < SubsystemCount; ++i)
+	{
+		LastFrame[i].Allocations = AllocationCounts[i].exchange(0, std::memory_order_relaxed);
+		LastFrame[i].Bytes = ByteCounts[i].exchange(0, std::memory_order_relaxed);
+
+		// Steady state frames must make no heap allocations at all. Each subsystem is only logged
+		// once so a leak in the frame loop doesn't flood the log.
+		if (IsSteadyState && i != (int)Subsystem::Startup && LastFrame[i].Allocations > 0)
+		{
+			HasSteadyStateAllocations = true;
+			if (!HasWarned[i])
+			{
+				TraceLog(LOG_ERROR, "ALLOC: %s made %u heap allocations (%llu bytes) in a steady state frame",
+					GetSubsystemName((Subsystem)i), LastFrame[i].Allocations, LastFrame[i].Bytes);
+				HasWarned[i] = true;
+			}
+		}
+	}
+}
+
+void AllocationTracker::BeginSteadyState()
+{
+	IsSteadyState = true;
+}
+
+bool AllocationTracker::HasFailed()
+{
+	return HasSteadyStateAllocations;
+}
+
+AllocationStats AllocationTracker::GetFrameStats(Subsystem subsystem)
+{
+	return LastFrame[(int)subsystem];
+}
+
+AllocationStats AllocationTracker::GetFrameTotal()
+{
+	AllocationStats total;
+	for (int i = 0; i < SubsystemCount; ++i)
+	{
+		total.Allocations += LastFrame[i].Allocations;
+		total.Bytes += LastFrame[i].Bytes;
+	}
+	return total;
+}
+
+const char* AllocationTracker::GetSubsystemName(Subsystem subsystem)
+{
+	switch (subsystem)
+	{
+	case Subsystem::Startup: return "Startup";
+	case Subsystem::Render: return "Render";
+	case Subsystem::Simulation: return "Simulation";
+	case Subsystem::Input: return "Input";
+	default: return "Unknown";
+	}
+}
+
+AllocationScope::AllocationScope(Subsystem subsystem)
+{
+	Previous = CurrentSubsystem;
+	CurrentSubsystem = subsystem;
+}
+
+AllocationScope::~AllocationScope()
+{
+	CurrentSubsystem = Previous;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+enum class Subsystem
+{
+	Startup,
+	Render,
+	Simulation,
+	Input,
+	Count
+};
+
+struct AllocationStats
+{
+	unsigned int Allocations = 0;
+	unsigned long long Bytes = 0;
+};
+
+/// <summary>
+/// Counts every C++ heap allocation (operator new) made by the program, per frame and per
+/// subsystem. Allocations are attributed to whichever subsystem is active on the allocating
+/// thread, see AllocationScope. raylib is C and allocates with malloc, so it isn't counted.
+/// </summary>
+class AllocationTracker
+{
+public:
+	/// <summary>
+	/// Closes off the current frame. Call once per rendered frame.
+	/// </summary>
+	static void EndFrame();
+
+	/// <summary>
+	/// From here on, any frame where a subsystem other than Startup allocates is a failure. It's
+	/// logged and reported by HasFailed(), so that the program can exit with an error. Call once
+	/// loading is over and everything has warmed up.
+	/// </summary>
+	static void BeginSteadyState();
+
+	/// <summary>
+	/// True once any steady state frame has made a heap allocation.
+	/// </summary>
+	static bool HasFailed();
+
+	/// <summary>
+	/// Allocations made during the last completed frame.
+	/// </summary>
+	static AllocationStats GetFrameStats(Subsystem subsystem);
+	static AllocationStats GetFrameTotal();
+
+	static const char* GetSubsystemName(Subsystem subsystem);
+};
+
+/// <summary>
+/// Attributes allocations made on this thread to a subsystem for as long as it's alive.
+/// </summary>
+class AllocationScope
+{
+public:
+	AllocationScope(Subsystem subsystem);
+	~AllocationScope();
+
+private:
+	Subsystem Previous;
+};
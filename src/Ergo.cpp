@@ -1,16 +1,26 @@
 #include <raylib.h>
+#include <cstdlib>
+#include <cstring>
 
 #include "Actor.h"
+#include "AllocationTracker.h"
+#include "RenderStats.h"
 #include "Ship.h"
 #include "SpaceDust.h"
 #include "GameCamera.h"
 #include "MathUtils.h"
+#include "MeshBVH.h"
+#include "Simulation.h"
+#include "TextureAtlas.h"
 
 //#define RENDER_SMALL
 
 int g_ScreenWidth = 800;
 int g_ScreenHeight = 600;
 
+// Frames after this are expected to make no heap allocations. See AllocationTracker.
+int g_SteadyStateFrame = 120;
+
 #ifdef RENDER_SMALL
 int g_RenderWidth = 400;
 int g_RenderHeight = 300;
@@ -18,65 +28,72 @@ int g_RenderHeight = 300;
 
 void DrawStandardFPS()
 {
-	BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+	RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
 	DrawText(TextFormat("FPS %d", GetFPS()), 10, 10, 10, GREEN);
-	EndBlendMode();
+	RenderStats::EndBlendMode();
 }
 
-void ApplyInputToShip(Ship& ship)
+void DrawSimulationStats(const FrameSnapshot& frame)
 {
-	ship.InputForward = 0;
-	if (IsKeyDown(KEY_W)) ship.InputForward += 1;
-	if (IsKeyDown(KEY_S)) ship.InputForward -= 1;
-
-	ship.InputForward -= GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_LEFT_Y);
-	ship.InputForward = Clamp(ship.InputForward, -1, 1);
-
-	ship.InputLeft = 0;
-	if (IsKeyDown(KEY_D)) ship.InputLeft -= 1;
-	if (IsKeyDown(KEY_A)) ship.InputLeft += 1;
-
-	ship.InputLeft -= GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_LEFT_X);
-	ship.InputLeft = Clamp(ship.InputLeft, -1, 1);
-
-	ship.InputUp = 0;
-	if (IsKeyDown(KEY_SPACE)) ship.InputUp += 1;
-	if (IsKeyDown(KEY_LEFT_CONTROL)) ship.InputUp -= 1;
-
-	auto triggerRight = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_RIGHT_TRIGGER);
-	triggerRight = Remap(triggerRight, -1, 1, 0, 1);
-
-	auto triggerLeft = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_LEFT_TRIGGER);
-	triggerLeft = Remap(triggerLeft, -1, 1, 0, 1);
-
-	ship.InputUp += triggerRight;
-	ship.InputUp -= triggerLeft;
-	ship.InputUp = Clamp(ship.InputUp, -1, 1);
-
-	ship.InputYawLeft = 0;
-	if (IsKeyDown(KEY_RIGHT)) ship.InputYawLeft -= 1;
-	if (IsKeyDown(KEY_LEFT)) ship.InputYawLeft += 1;
-
-	ship.InputYawLeft -= GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_RIGHT_X);
-	ship.InputYawLeft = Clamp(ship.InputYawLeft, -1, 1);
+	RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+	DrawText(TextFormat("SIM %.2fms", frame.TickMilliseconds), 10, 22, 10, GREEN);
+	DrawText(TextFormat("INPUT QUEUE %.1fms (MAX %.1fms)", frame.InputQueueMilliseconds, frame.InputQueueMaxMilliseconds), 10, 34, 10, GREEN);
+	DrawText(TextFormat("REWIND %.3fms %d TICKS (%zu KB)", frame.RewindMilliseconds, frame.RewindTicks, frame.RewindBytes / 1024), 10, 58, 10, frame.Rewinding ? SKYBLUE : GREEN);
+	RenderStats::EndBlendMode();
+}
 
-	ship.InputPitchDown = 0;
-	if (IsKeyDown(KEY_UP)) ship.InputPitchDown += 1;
-	if (IsKeyDown(KEY_DOWN)) ship.InputPitchDown -= 1;
+void DrawAllocationStats()
+{
+	auto total = AllocationTracker::GetFrameTotal();
 
-	ship.InputPitchDown += GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_RIGHT_Y);
-	ship.InputPitchDown = Clamp(ship.InputPitchDown, -1, 1);
+	RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+	DrawText(TextFormat("ALLOC %u (%llu BYTES)", total.Allocations, total.Bytes), 10, 46, 10, total.Allocations > 0 ? YELLOW : GREEN);
+	for (int i = 0; i < (int)Subsystem::Count; ++i)
+	{
+		auto subsystem = (Subsystem)i;
+		auto stats = AllocationTracker::GetFrameStats(subsystem);
+		DrawText(TextFormat("ALLOC %s %u (%llu BYTES)", TextToUpper(AllocationTracker::GetSubsystemName(subsystem)),
+			stats.Allocations, stats.Bytes), 10, 106 + i * 12, 10, stats.Allocations > 0 ? YELLOW : GREEN);
+	}
+	RenderStats::EndBlendMode();
+}
 
-	ship.InputRollRight = 0;
-	if (IsKeyDown(KEY_Q)) ship.InputRollRight -= 1;
-	if (IsKeyDown(KEY_E)) ship.InputRollRight += 1;
+void DrawRenderStats()
+{
+	RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+	for (int i = 0; i < (int)RenderPass::Count; ++i)
+	{
+		auto pass = (RenderPass)i;
+		auto stats = RenderStats::GetFrameStats(pass);
+		DrawText(TextFormat("%s %u DRAWS %u FLUSHES %u VERTS %u TRIS %u BLEND %u DEPTH %u TEX",
+			TextToUpper(RenderStats::GetPassName(pass)), stats.DrawCalls, stats.BatchFlushes,
+			stats.Vertices, stats.Triangles, stats.BlendChanges, stats.DepthChanges, stats.TextureBinds),
+			10, 70 + i * 12, 10, GREEN);
+	}
+	RenderStats::EndBlendMode();
 }
 
-int main()
+int main(int argc, char** argv)
 {
+	// --stats-csv <path> writes render stats for every frame to a CSV file.
+	// --frames <count> quits after that many frames, for unattended runs.
+	const char* statsPath = nullptr;
+	int frameLimit = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--stats-csv") == 0 && i + 1 < argc)
+			statsPath = argv[++i];
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frameLimit = atoi(argv[++i]);
+	}
+
 	SetConfigFlags(ConfigFlags::FLAG_MSAA_4X_HINT | ConfigFlags::FLAG_VSYNC_HINT);
 	InitWindow(g_ScreenWidth, g_ScreenHeight, "Ergo");
 
+	RenderStats::Init();
+	if (statsPath != nullptr)
+		RenderStats::OpenCsv(statsPath);
+
 #ifdef RENDER_SMALL
 	// Set up low resolution rendering independent from the window resolution.
 	auto renderRatio = (float)g_ScreenWidth / (float)g_RenderWidth;
@@ -91,51 +108,36 @@ int main()
 	screenSpaceCamera.zoom = 1.0f;
 #endif // RENDER_SMALL
 
-	Ship player("data/ship.gltf", "data/a16.png", RAYWHITE);
-	Ship other("data/ship.gltf", "data/a16.png", RAYWHITE);
-	other.TrailColor = MAROON;
-	other.Position = { 10, 2, 10 };
-	SpaceDust dust = SpaceDust(25, 255);
-
-	GameCamera cameraFlight = GameCamera(true, 50);
 	GameCamera cameraHUD = GameCamera(false, 50);
 	cameraHUD.SetPosition({ 0, 0, -10 }, { 0, 0, 0 }, { 0, 1, 0 });
 
-	// Test station.
-	Texture2D texture = LoadTexture("data/a16.png");
-	texture.mipmaps = 0;
-	SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+	// Every textured model shares this atlas, which is packed once and then cached.
+	TextureAtlas textureAtlas;
+	textureAtlas.Add("data/a16.png");
+	if (!textureAtlas.LoadOrBuild("data/textures.atlas", AtlasOptions()))
+		TraceLog(LOG_WARNING, "ATLAS: Failed to load the texture atlas, models will use their own textures");
+
+	// Test station. If the atlas can't be used, it keeps the texture it loaded with.
 	Model stationModel = LoadModel("data/station.gltf");
-	stationModel.materials[0].maps[MaterialMapIndex::MATERIAL_MAP_ALBEDO].texture = texture;
+	if (!textureAtlas.ApplyToModel(stationModel, "data/a16.png"))
+		TraceLog(LOG_WARNING, "ATLAS: [data/station.gltf] Using the model's own texture");
 	stationModel.transform = MatrixTranslate(0, 5, 50);
 
-	Crosshair crosshairNear = Crosshair("data/crosshair2.gltf");
-	Crosshair crosshairFar = Crosshair("data/crosshair2.gltf");
-
-	while (!WindowShouldClose())
-	{
-		auto deltaTime = GetFrameTime();
+	MeshBVH stationCollision;
+	stationCollision.LoadOrBuild("data/station.gltf", stationModel);
+	stationCollision.SetTransform(stationModel.transform);
 
-		// Capture input
-		{
-			ApplyInputToShip(player);
-			ApplyInputToShip(other);
-		}
+	// Ships, camera and dust run on the simulation thread. This thread owns the window and only
+	// renders whatever frame the simulation most recently finished.
+	Simulation simulation = Simulation(&stationCollision, textureAtlas);
+	simulation.Start();
 
-		// Gameplay updates
-		{
-			player.Update(deltaTime);
-			other.Update(deltaTime);
+	AllocationScope allocationScope(Subsystem::Render);
+	int frameCount = 0;
 
-			crosshairNear.PositionCrosshairOnShip(player, 10);
-			crosshairFar.PositionCrosshairOnShip(player, 30);
-		}
-
-		// Camera movement and visual effects
-		{
-			cameraFlight.FollowShip(player, deltaTime);
-			dust.UpdateViewPosition(cameraFlight.GetPosition());
-		}
+	while (!WindowShouldClose() && (frameLimit == 0 || frameCount < frameLimit))
+	{
+		const FrameSnapshot& frame = simulation.AcquireFrame();
 
 		// Render
 #ifdef RENDER_SMALL
@@ -146,30 +148,33 @@ int main()
 		{
 			ClearBackground({32, 32, 64, 255});
 
-			cameraFlight.Begin3DDrawing();
+			BeginMode3D(frame.Camera);
 			{
 				// Opaques
+				RenderStats::BeginPass(RenderPass::Opaque);
 				{
 					DrawGrid(10, 10);
 
-					player.Draw(false);
-					other.Draw(false);
+					for (int i = 0; i < frame.ShipCount; ++i)
+						simulation.GetShip(i).Draw(frame.Ships[i], false);
 
-					DrawModel(stationModel, Vector3Zero(), 1, WHITE);
+					RenderStats::DrawModel(stationModel, Vector3Zero(), 1, WHITE);
 				}
 
 				// Transparencies
+				RenderStats::BeginPass(RenderPass::Transparent);
 				{
-					player.DrawTrail();
-					other.DrawTrail();
+					for (int i = 0; i < frame.ShipCount; ++i)
+						Ship::DrawTrail(frame.Ships[i]);
 
-					crosshairNear.DrawCrosshair();
-					crosshairFar.DrawCrosshair();
+					for (int i = 0; i < frame.CrosshairCount; ++i)
+						simulation.GetCrosshair(i).DrawCrosshair(frame.Crosshairs[i]);
 
-					dust.Draw(cameraFlight.GetPosition(), player.Velocity, false);
+					simulation.GetDust().Draw(frame.DustPoints, frame.DustCount, frame.Camera.position, frame.PlayerVelocity, false);
 				}
+				RenderStats::EndPass();
 			}
-			cameraFlight.EndDrawing();
+			EndMode3D();
 
 			//cameraHUD.Begin3DDrawing();
 			//{
@@ -178,7 +183,12 @@ int main()
 			//}
 			//cameraHUD.EndDrawing();
 
+			RenderStats::BeginPass(RenderPass::Overlay);
 			DrawStandardFPS();
+			DrawSimulationStats(frame);
+			DrawAllocationStats();
+			DrawRenderStats();
+			RenderStats::EndPass();
 		}
 #ifdef RENDER_SMALL
 		EndTextureMode();
@@ -198,9 +208,27 @@ int main()
 		}
 		EndDrawing();
 #endif // RENDER_SMALL
+
+		// EndDrawing() has just polled window events.
+		simulation.SampleInput();
+
+		RenderStats::EndFrame();
+		AllocationTracker::EndFrame();
+		if (++frameCount == g_SteadyStateFrame)
+			AllocationTracker::BeginSteadyState();
 	}
 
+	simulation.Stop();
+	RenderStats::Shutdown();
+	textureAtlas.Unload();
 	CloseWindow();
 
+	// Lets unattended runs (see --frames) catch allocations creeping back into the frame loop.
+	if (AllocationTracker::HasFailed())
+	{
+		TraceLog(LOG_ERROR, "ALLOC: Heap allocations were made in steady state frames");
+		return 1;
+	}
+
 	return 0;
 }
@@ -0,0 +1,49 @@
+#include "FrameArena.h"
+
+#include <raylib.h>
+
+FrameArena::FrameArena(size_t capacity)
+{
+	Memory = new unsigned char[capacity];
+	Capacity = capacity;
+	Used = 0;
+	HasOverflowed = false;
+}
+
+FrameArena::~FrameArena()
+{
+	delete[] Memory;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	size_t start = (Used + alignment - 1) & ~(alignment - 1);
+	if (start + size > Capacity)
+	{
+		// Only report the first time, otherwise this would spam the log every frame.
+		if (!HasOverflowed)
+		{
+			TraceLog(LOG_WARNING, "ARENA: Out of space allocating %zu bytes (%zu of %zu used)", size, Used, Capacity);
+			HasOverflowed = true;
+		}
+		return nullptr;
+	}
+
+	Used = start + size;
+	return Memory + start;
+}
+
+void FrameArena::Reset()
+{
+	Used = 0;
+}
+
+size_t FrameArena::GetUsed() const
+{
+	return Used;
+}
+
+size_t FrameArena::GetCapacity() const
+{
+	return Capacity;
+}
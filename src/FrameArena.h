@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+/// <summary>
+/// Linear allocator for data that only lives for a frame. Allocating is a pointer bump and
+/// everything is released at once with Reset(). Memory is reserved up front, so allocating from
+/// an arena never touches the heap.
+/// </summary>
+class FrameArena
+{
+public:
+	FrameArena(size_t capacity);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	/// <summary>
+	/// Returns nullptr when the arena doesn't have enough space left.
+	/// </summary>
+	void* Allocate(size_t size, size_t alignment);
+
+	template <typename T>
+	T* AllocateArray(int count)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/// <summary>
+	/// Releases everything allocated since the last reset.
+	/// </summary>
+	void Reset();
+
+	size_t GetUsed() const;
+	size_t GetCapacity() const;
+
+private:
+	unsigned char* Memory;
+	size_t Capacity;
+	size_t Used;
+	bool HasOverflowed;
+};
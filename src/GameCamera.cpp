@@ -63,6 +63,11 @@ Vector3 GameCamera::GetPosition() const
 	return Camera.position;
 }
 
+Camera3D GameCamera::GetCamera() const
+{
+	return Camera;
+}
+
 void GameCamera::Begin3DDrawing() const
 {
 	BeginMode3D(Camera);
@@ -37,6 +37,7 @@ public:
 	void EndDrawing() const;
 
 	Vector3 GetPosition() const;
+	Camera3D GetCamera() const;
 
 private:
 	Camera3D Camera;
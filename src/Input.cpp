@@ -0,0 +1,246 @@
+#include "Input.h"
+
+#include <raylib.h>
+#include <raymath.h>
+#include <chrono>
+
+#include "AllocationTracker.h"
+
+#if defined(_WIN32)
+// Implemented in InputWin32.cpp, which can't include raylib.h alongside windows.h.
+bool ReadControlStateWin32(ControlState& state);
+#endif
+
+static void ReadControlState(ControlState& state)
+{
+#if defined(_WIN32)
+	// Reads the devices directly, so input is seen as soon as it happens rather than the next
+	// time the window pumps its events.
+	if (!ReadControlStateWin32(state))
+		state = ControlState();
+#else
+	// Elsewhere raylib's key and gamepad state is the only source. raylib updates it while the
+	// main thread polls window events, so it's only safe to read from that thread, see
+	// InputSampler::SampleOnEventThread(). Changes arrive at the frame rate, but they're still
+	// timestamped and queued the same way.
+	state.Forward = IsKeyDown(KEY_W);
+	state.Back = IsKeyDown(KEY_S);
+	state.StrafeLeft = IsKeyDown(KEY_A);
+	state.StrafeRight = IsKeyDown(KEY_D);
+	state.Up = IsKeyDown(KEY_SPACE);
+	state.Down = IsKeyDown(KEY_LEFT_CONTROL);
+	state.YawLeft = IsKeyDown(KEY_LEFT);
+	state.YawRight = IsKeyDown(KEY_RIGHT);
+	state.PitchDown = IsKeyDown(KEY_UP);
+	state.PitchUp = IsKeyDown(KEY_DOWN);
+	state.RollLeft = IsKeyDown(KEY_Q);
+	state.RollRight = IsKeyDown(KEY_E);
+	state.Rewind = IsKeyDown(KEY_R) || IsGamepadButtonDown(0, GamepadButton::GAMEPAD_BUTTON_MIDDLE_LEFT);
+
+	state.LeftX = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_LEFT_X);
+	state.LeftY = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_LEFT_Y);
+	state.RightX = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_RIGHT_X);
+	state.RightY = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_RIGHT_Y);
+	state.LeftTrigger = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_LEFT_TRIGGER);
+	state.RightTrigger = GetGamepadAxisMovement(0, GamepadAxis::GAMEPAD_AXIS_RIGHT_TRIGGER);
+#endif
+}
+
+static bool operator!=(const ShipInput& a, const ShipInput& b)
+{
+	return a.Forward != b.Forward
+		|| a.Left != b.Left
+		|| a.Up != b.Up
+		|| a.PitchDown != b.PitchDown
+		|| a.RollRight != b.RollRight
+		|| a.YawLeft != b.YawLeft;
+}
+
+ShipInput ToShipInput(const ControlState& state)
+{
+	ShipInput input;
+
+	if (state.Forward) input.Forward += 1;
+	if (state.Back) input.Forward -= 1;
+
+	input.Forward -= state.LeftY;
+	input.Forward = Clamp(input.Forward, -1, 1);
+
+	if (state.StrafeRight) input.Left -= 1;
+	if (state.StrafeLeft) input.Left += 1;
+
+	input.Left -= state.LeftX;
+	input.Left = Clamp(input.Left, -1, 1);
+
+	if (state.Up) input.Up += 1;
+	if (state.Down) input.Up -= 1;
+
+	auto triggerRight = Remap(state.RightTrigger, -1, 1, 0, 1);
+	auto triggerLeft = Remap(state.LeftTrigger, -1, 1, 0, 1);
+
+	input.Up += triggerRight;
+	input.Up -= triggerLeft;
+	input.Up = Clamp(input.Up, -1, 1);
+
+	if (state.YawRight) input.YawLeft -= 1;
+	if (state.YawLeft) input.YawLeft += 1;
+
+	input.YawLeft -= state.RightX;
+	input.YawLeft = Clamp(input.YawLeft, -1, 1);
+
+	if (state.PitchDown) input.PitchDown += 1;
+	if (state.PitchUp) input.PitchDown -= 1;
+
+	input.PitchDown += state.RightY;
+	input.PitchDown = Clamp(input.PitchDown, -1, 1);
+
+	if (state.RollLeft) input.RollRight -= 1;
+	if (state.RollRight) input.RollRight += 1;
+
+	return input;
+}
+
+double GetInputTime()
+{
+	using namespace std::chrono;
+	static const auto start = steady_clock::now();
+	return duration<double>(steady_clock::now() - start).count();
+}
+
+bool InputQueue::Push(const InputEvent& event)
+{
+	auto tail = Tail.load(std::memory_order_relaxed);
+	if (tail - Head.load(std::memory_order_acquire) >= Capacity)
+		return false;
+
+	Events[tail % Capacity] = event;
+	Tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::Pop(InputEvent& event)
+{
+	auto head = Head.load(std::memory_order_relaxed);
+	if (head == Tail.load(std::memory_order_acquire))
+		return false;
+
+	event = Events[head % Capacity];
+	Head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+InputSampler::InputSampler(int sampleRate)
+{
+	SampleRate = sampleRate;
+}
+
+InputSampler::~InputSampler()
+{
+	Stop();
+}
+
+void InputSampler::Start()
+{
+	if (Running)
+		return;
+
+	Running = true;
+	if (SamplesOnOwnThread)
+		Thread = std::thread(&InputSampler::Run, this);
+}
+
+void InputSampler::Stop()
+{
+	Running = false;
+	if (Thread.joinable())
+		Thread.join();
+}
+
+void InputSampler::SampleOnEventThread()
+{
+	if (!SamplesOnOwnThread && Running)
+		Sample();
+}
+
+int InputSampler::PollEvents(InputEvent* events, int maxEvents)
+{
+	int count = 0;
+	while (count < maxEvents && Queue.Pop(events[count]))
+		count++;
+	return count;
+}
+
+void InputSampler::Run()
+{
+	using namespace std::chrono;
+	AllocationScope allocationScope(Subsystem::Input);
+
+	// raylib raises the Windows timer resolution to 1ms, so sleeping between samples is accurate
+	// enough for rates up to 1000hz.
+	const auto period = duration_cast<steady_clock::duration>(duration<double>(1.0 / SampleRate));
+	auto nextSample = steady_clock::now();
+
+	while (Running)
+	{
+		Sample();
+
+		nextSample += period;
+		std::this_thread::sleep_until(nextSample);
+	}
+}
+
+void InputSampler::Sample()
+{
+	ControlState state;
+	ReadControlState(state);
+	auto input = ToShipInput(state);
+
+	// When the queue is full the event is dropped, but since the controls still differ from the
+	// last queued ones it gets retried on the next sample.
+	if (!AnyQueued || input != LastQueued || state.Rewind != LastRewind)
+	{
+		if (Queue.Push({ GetInputTime(), input, state.Rewind }))
+		{
+			LastQueued = input;
+			LastRewind = state.Rewind;
+			AnyQueued = true;
+		}
+	}
+}
+
+void InputQueueDelay::Record(double sampleTime, double appliedTime)
+{
+	double delay = appliedTime - sampleTime;
+	WindowTotal += delay;
+	WindowMax = delay > WindowMax ? delay : WindowMax;
+	WindowCount++;
+}
+
+void InputQueueDelay::Update(double now)
+{
+	if (now - WindowStart < 1.0)
+		return;
+
+	// Only replace the reported figures when something was actually measured, so the readout
+	// doesn't drop to zero whenever the controls are left alone.
+	if (WindowCount > 0)
+	{
+		AverageMilliseconds = (float)(WindowTotal / WindowCount * 1000.0);
+		MaxMilliseconds = (float)(WindowMax * 1000.0);
+	}
+
+	WindowStart = now;
+	WindowTotal = 0;
+	WindowMax = 0;
+	WindowCount = 0;
+}
+
+float InputQueueDelay::GetAverageMilliseconds() const
+{
+	return AverageMilliseconds;
+}
+
+float InputQueueDelay::GetMaxMilliseconds() const
+{
+	return MaxMilliseconds;
+}
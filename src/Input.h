@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+struct ShipInput
+{
+	float Forward = 0;
+	float Left = 0;
+	float Up = 0;
+
+	float PitchDown = 0;
+	float RollRight = 0;
+	float YawLeft = 0;
+};
+
+/// <summary>
+/// Raw state of the keys and gamepad axes the ship is flown with. Axes follow raylib's
+/// conventions (-1 to 1, including the triggers) no matter which platform layer filled them in.
+/// </summary>
+struct ControlState
+{
+	bool Forward = false;
+	bool Back = false;
+	bool StrafeLeft = false;
+	bool StrafeRight = false;
+	bool Up = false;
+	bool Down = false;
+	bool YawLeft = false;
+	bool YawRight = false;
+	bool PitchDown = false;
+	bool PitchUp = false;
+	bool RollLeft = false;
+	bool RollRight = false;
+	bool Rewind = false;
+
+	float LeftX = 0;
+	float LeftY = 0;
+	float RightX = 0;
+	float RightY = 0;
+	float LeftTrigger = -1;
+	float RightTrigger = -1;
+};
+
+struct InputEvent
+{
+	double Time;
+	ShipInput Ship;
+	bool Rewind;
+};
+
+/// <summary>
+/// Combines keyboard and gamepad into the ship's controls.
+/// </summary>
+ShipInput ToShipInput(const ControlState& state);
+
+/// <summary>
+/// Seconds on the clock input events are timestamped with.
+/// </summary>
+double GetInputTime();
+
+/// <summary>
+/// Lock free queue with exactly one producer thread and one consumer thread.
+/// </summary>
+class InputQueue
+{
+public:
+	/// <summary>
+	/// Producer side. Returns false without queueing anything when the queue is full.
+	/// </summary>
+	bool Push(const InputEvent& event);
+
+	/// <summary>
+	/// Consumer side. Returns false when there's nothing queued.
+	/// </summary>
+	bool Pop(InputEvent& event);
+
+private:
+	static const unsigned int Capacity = 1024;
+	InputEvent Events[Capacity] = {};
+
+	std::atomic<unsigned int> Head = 0;
+	std::atomic<unsigned int> Tail = 0;
+};
+
+/// <summary>
+/// Samples the controls on a dedicated thread at a fixed rate, independent of the frame rate.
+/// An event is queued every time the controls change. Only Windows can read the devices off the
+/// main thread; elsewhere the controls are sampled once per frame by SampleOnEventThread().
+/// </summary>
+class InputSampler
+{
+public:
+	InputSampler(int sampleRate);
+	~InputSampler();
+
+	void Start();
+	void Stop();
+
+	/// <summary>
+	/// Call once per frame from the thread that polls window events, after polling. Does
+	/// nothing on platforms where the controls are sampled on their own thread.
+	/// </summary>
+	void SampleOnEventThread();
+
+	/// <summary>
+	/// Takes every event queued since the last call, oldest first, up to maxEvents.
+	/// </summary>
+	int PollEvents(InputEvent* events, int maxEvents);
+
+private:
+	InputQueue Queue;
+	std::thread Thread;
+	std::atomic<bool> Running = false;
+	int SampleRate;
+
+#if defined(_WIN32)
+	static const bool SamplesOnOwnThread = true;
+#else
+	static const bool SamplesOnOwnThread = false;
+#endif
+
+	// Only touched by whichever thread is sampling.
+	ShipInput LastQueued;
+	bool LastRewind = false;
+	bool AnyQueued = false;
+
+	void Run();
+	void Sample();
+};
+
+/// <summary>
+/// Tracks how long input events wait in the queue between being sampled and being applied to
+/// the simulation. That's only part of the delay between pressing a button and the ship moving,
+/// since it leaves out the time before the sample and the rendering afterwards. Reported figures
+/// cover the last full second.
+/// </summary>
+class InputQueueDelay
+{
+public:
+	void Record(double sampleTime, double appliedTime);
+	void Update(double now);
+
+	float GetAverageMilliseconds() const;
+	float GetMaxMilliseconds() const;
+
+private:
+	double WindowStart = 0;
+	double WindowTotal = 0;
+	double WindowMax = 0;
+	int WindowCount = 0;
+
+	float AverageMilliseconds = 0;
+	float MaxMilliseconds = 0;
+};
@@ -0,0 +1,109 @@
+#if defined(_WIN32)
+
+// windows.h clashes with raylib.h (CloseWindow, Rectangle, DrawText...), so the Win32 side of
+// input sampling lives in its own translation unit that never includes raylib.
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <Xinput.h>
+
+#include "Input.h"
+
+#pragma comment(lib, "xinput.lib")
+
+// How long to wait before checking an empty controller slot again. XInputGetState() is slow
+// when nothing is connected.
+static const ULONGLONG PadRetryMilliseconds = 1000;
+
+static ULONGLONG NextPadCheck = 0;
+
+static bool IsHeld(int virtualKey)
+{
+	return (GetAsyncKeyState(virtualKey) & 0x8000) != 0;
+}
+
+// Values inside the deadzone are dropped rather than rescaled, the same as raylib does with
+// its own drift threshold, so sticks respond the same on either path.
+static float ThumbToAxis(SHORT value, SHORT deadzone)
+{
+	if (value > -deadzone && value < deadzone)
+		return 0;
+
+	return value < 0 ? value / 32768.0f : value / 32767.0f;
+}
+
+static float TriggerToAxis(BYTE value)
+{
+	if (value < XINPUT_GAMEPAD_TRIGGER_THRESHOLD)
+		value = 0;
+
+	return (value / 255.0f) * 2.0f - 1.0f;
+}
+
+static bool ReadPad(XINPUT_STATE& pad)
+{
+	ULONGLONG now = GetTickCount64();
+	if (now < NextPadCheck)
+		return false;
+
+	DWORD result = XInputGetState(0, &pad);
+	if (result == ERROR_DEVICE_NOT_CONNECTED)
+		NextPadCheck = now + PadRetryMilliseconds;
+
+	return result == ERROR_SUCCESS;
+}
+
+static bool IsGameFocused()
+{
+	DWORD processId = 0;
+	GetWindowThreadProcessId(GetForegroundWindow(), &processId);
+	return processId == GetCurrentProcessId();
+}
+
+bool ReadControlStateWin32(ControlState& state)
+{
+	// GetAsyncKeyState reports keys no matter which window has focus.
+	if (!IsGameFocused())
+		return false;
+
+	state.Forward = IsHeld('W');
+	state.Back = IsHeld('S');
+	state.StrafeLeft = IsHeld('A');
+	state.StrafeRight = IsHeld('D');
+	state.Up = IsHeld(VK_SPACE);
+	state.Down = IsHeld(VK_LCONTROL);
+	state.YawLeft = IsHeld(VK_LEFT);
+	state.YawRight = IsHeld(VK_RIGHT);
+	state.PitchDown = IsHeld(VK_UP);
+	state.PitchUp = IsHeld(VK_DOWN);
+	state.RollLeft = IsHeld('Q');
+	state.RollRight = IsHeld('E');
+	state.Rewind = IsHeld('R');
+
+	XINPUT_STATE pad = {};
+	if (ReadPad(pad))
+	{
+		// XInput's sticks are up-positive, raylib's are down-positive.
+		state.LeftX = ThumbToAxis(pad.Gamepad.sThumbLX, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+		state.LeftY = -ThumbToAxis(pad.Gamepad.sThumbLY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+		state.RightX = ThumbToAxis(pad.Gamepad.sThumbRX, XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE);
+		state.RightY = -ThumbToAxis(pad.Gamepad.sThumbRY, XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE);
+		state.LeftTrigger = TriggerToAxis(pad.Gamepad.bLeftTrigger);
+		state.RightTrigger = TriggerToAxis(pad.Gamepad.bRightTrigger);
+		state.Rewind |= (pad.Gamepad.wButtons & XINPUT_GAMEPAD_BACK) != 0;
+	}
+	else
+	{
+		state.LeftX = 0;
+		state.LeftY = 0;
+		state.RightX = 0;
+		state.RightY = 0;
+		state.LeftTrigger = -1;
+		state.RightTrigger = -1;
+	}
+
+	return true;
+}
+
+#endif // _WIN32
@@ -25,6 +25,35 @@ inline Quaternion SmoothDamp(Quaternion from, Quaternion to, float speed, float
 	return QuaternionSlerp( from, to, 1 - expf(-speed * dt));
 }
 
+// ==================================================================================
+// Exponential map: turns a rotation vector (axis scaled by angle in radians) into a
+// quaternion. Unlike QuaternionFromAxisAngle, the axis doesn't need to be normalized
+// first, and a zero rotation is fine.
+// ==================================================================================
+
+inline Quaternion QuaternionFromRotationVector(Vector3 rotation)
+{
+	float angleSquared = Vector3DotProduct(rotation, rotation);
+
+	// For tiny angles, sin(a/2)/a and cos(a/2) are replaced with their Taylor series, which are
+	// exact at float precision and avoid dividing by (nearly) zero.
+	float scale;
+	float w;
+	if (angleSquared < 1e-6f)
+	{
+		scale = 0.5f - angleSquared / 48.0f;
+		w = 1.0f - angleSquared / 8.0f;
+	}
+	else
+	{
+		float angle = sqrtf(angleSquared);
+		scale = sinf(angle * 0.5f) / angle;
+		w = cosf(angle * 0.5f);
+	}
+
+	return Quaternion{ rotation.x * scale, rotation.y * scale, rotation.z * scale, w };
+}
+
 //
 //inline float InverseLerp(float from, float to, float value)
 //{
@@ -0,0 +1,721 @@
+#include "MeshBVH.h"
+
+#include <raymath.h>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+
+static const int BinCount = 12;
+static const int MaxLeafTriangles = 2;
+static const int MaxStackDepth = 64;
+
+// Traversal keeps at most one pending sibling per level plus the two children being pushed, so
+// capping the depth here is what guarantees the fixed size stack never overflows.
+static const int MaxTreeDepth = MaxStackDepth - 1;
+
+static const char CacheMagic[4] = { 'E', 'B', 'V', 'H' };
+static const int CacheVersion = 2;
+
+struct CacheHeader
+{
+	char Magic[4];
+	int Version;
+	long long SourceModTime;
+	int TriangleCount;
+	int NodeCount;
+};
+
+struct Bin
+{
+	Vector3 Min = { FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	int Count = 0;
+};
+
+static float GetAxis(Vector3 v, int axis)
+{
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static float SurfaceArea(Vector3 min, Vector3 max)
+{
+	auto e = Vector3Subtract(max, min);
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+static void GrowBounds(Vector3& min, Vector3& max, Vector3 point)
+{
+	min = Vector3Min(min, point);
+	max = Vector3Max(max, point);
+}
+
+static Vector3 TransformDirection(Vector3 v, Matrix m)
+{
+	return Vector3{
+		m.m0 * v.x + m.m4 * v.y + m.m8 * v.z,
+		m.m1 * v.x + m.m5 * v.y + m.m9 * v.z,
+		m.m2 * v.x + m.m6 * v.y + m.m10 * v.z };
+}
+
+// Slab test. Returns the distance along the ray where it enters the box, or FLT_MAX on a miss.
+static float IntersectAABB(Vector3 origin, Vector3 invDirection, Vector3 min, Vector3 max, float maxDistance)
+{
+	float tx1 = (min.x - origin.x) * invDirection.x;
+	float tx2 = (max.x - origin.x) * invDirection.x;
+	float tMin = fminf(tx1, tx2);
+	float tMax = fmaxf(tx1, tx2);
+
+	float ty1 = (min.y - origin.y) * invDirection.y;
+	float ty2 = (max.y - origin.y) * invDirection.y;
+	tMin = fmaxf(tMin, fminf(ty1, ty2));
+	tMax = fminf(tMax, fmaxf(ty1, ty2));
+
+	float tz1 = (min.z - origin.z) * invDirection.z;
+	float tz2 = (max.z - origin.z) * invDirection.z;
+	tMin = fmaxf(tMin, fminf(tz1, tz2));
+	tMax = fminf(tMax, fmaxf(tz1, tz2));
+
+	if (tMax >= tMin && tMax > 0 && tMin < maxDistance)
+		return fmaxf(tMin, 0.0f);
+	return FLT_MAX;
+}
+
+static Vector3 SafeInverse(Vector3 direction)
+{
+	// Dividing by zero gives an infinity, which the slab test handles correctly. Negative zero
+	// would flip the sign of that infinity, so it's avoided here.
+	return Vector3{
+		1.0f / (direction.x == 0 ? 1e-30f : direction.x),
+		1.0f / (direction.y == 0 ? 1e-30f : direction.y),
+		1.0f / (direction.z == 0 ? 1e-30f : direction.z) };
+}
+
+// Möller-Trumbore, two sided.
+static bool IntersectTriangle(Vector3 origin, Vector3 direction, const BVHTriangle& tri, float& distance)
+{
+	const float epsilon = 1e-7f;
+
+	auto edge1 = Vector3Subtract(tri.B, tri.A);
+	auto edge2 = Vector3Subtract(tri.C, tri.A);
+	auto h = Vector3CrossProduct(direction, edge2);
+	float a = Vector3DotProduct(edge1, h);
+	if (fabsf(a) < epsilon)
+		return false;
+
+	float f = 1.0f / a;
+	auto s = Vector3Subtract(origin, tri.A);
+	float u = f * Vector3DotProduct(s, h);
+	if (u < 0 || u > 1)
+		return false;
+
+	auto q = Vector3CrossProduct(s, edge1);
+	float v = f * Vector3DotProduct(direction, q);
+	if (v < 0 || u + v > 1)
+		return false;
+
+	float t = f * Vector3DotProduct(edge2, q);
+	if (t < 0)
+		return false;
+
+	distance = t;
+	return true;
+}
+
+static bool PointInTriangle(Vector3 point, const BVHTriangle& tri, Vector3 normal)
+{
+	auto ab = Vector3CrossProduct(Vector3Subtract(tri.B, tri.A), Vector3Subtract(point, tri.A));
+	auto bc = Vector3CrossProduct(Vector3Subtract(tri.C, tri.B), Vector3Subtract(point, tri.B));
+	auto ca = Vector3CrossProduct(Vector3Subtract(tri.A, tri.C), Vector3Subtract(point, tri.C));
+	return Vector3DotProduct(ab, normal) >= 0
+		&& Vector3DotProduct(bc, normal) >= 0
+		&& Vector3DotProduct(ca, normal) >= 0;
+}
+
+// Ray against a sphere at a triangle corner. Rays starting inside the sphere only hit when
+// heading towards its center.
+static bool IntersectSphere(Vector3 origin, Vector3 direction, Vector3 center, float radius, float& distance)
+{
+	auto m = Vector3Subtract(origin, center);
+	float b = Vector3DotProduct(m, direction);
+	float c = Vector3DotProduct(m, m) - radius * radius;
+	if (b >= 0)
+		return false;
+
+	float discriminant = b * b - c;
+	if (discriminant < 0)
+		return false;
+
+	distance = fmaxf(-b - sqrtf(discriminant), 0.0f);
+	return true;
+}
+
+// Ray against the cylinder around a triangle edge. Hits beyond the ends of the edge are left to
+// the corner spheres.
+static bool IntersectEdgeCylinder(Vector3 origin, Vector3 direction, Vector3 p, Vector3 q, float radius, float& distance)
+{
+	auto edge = Vector3Subtract(q, p);
+	float edgeLengthSqr = Vector3DotProduct(edge, edge);
+	if (edgeLengthSqr < 1e-12f)
+		return false;
+
+	auto m = Vector3Subtract(origin, p);
+	auto dPerp = Vector3Subtract(direction, Vector3Scale(edge, Vector3DotProduct(direction, edge) / edgeLengthSqr));
+	auto mPerp = Vector3Subtract(m, Vector3Scale(edge, Vector3DotProduct(m, edge) / edgeLengthSqr));
+
+	float a = Vector3DotProduct(dPerp, dPerp);
+	float b = Vector3DotProduct(mPerp, dPerp);
+	float c = Vector3DotProduct(mPerp, mPerp) - radius * radius;
+
+	// Moving parallel to the edge, or moving away from it.
+	if (a < 1e-12f || b >= 0)
+		return false;
+
+	float discriminant = b * b - a * c;
+	if (discriminant < 0)
+		return false;
+
+	float t = fmaxf((-b - sqrtf(discriminant)) / a, 0.0f);
+	float s = Vector3DotProduct(Vector3Add(m, Vector3Scale(direction, t)), edge) / edgeLengthSqr;
+	if (s < 0 || s > 1)
+		return false;
+
+	distance = t;
+	return true;
+}
+
+static Vector3 ClosestPointOnSegment(Vector3 point, Vector3 p, Vector3 q)
+{
+	auto edge = Vector3Subtract(q, p);
+	float t = Vector3DotProduct(Vector3Subtract(point, p), edge) / fmaxf(Vector3DotProduct(edge, edge), 1e-12f);
+	return Vector3Add(p, Vector3Scale(edge, Clamp(t, 0, 1)));
+}
+
+// Swept sphere against a single triangle. Tests the face, then the three edges and corners.
+static bool SweepSphereTriangle(Vector3 origin, Vector3 direction, float radius, const BVHTriangle& tri, float& distance, Vector3& normal)
+{
+	auto faceNormal = Vector3CrossProduct(Vector3Subtract(tri.B, tri.A), Vector3Subtract(tri.C, tri.A));
+	if (Vector3LengthSqr(faceNormal) < 1e-12f)
+		return false;
+	faceNormal = Vector3Normalize(faceNormal);
+
+	// Triangles are two sided, so always face the sphere. The winding order of the corners
+	// doesn't change, so containment is still tested against the unflipped normal.
+	auto windingNormal = faceNormal;
+	float planeDistance = Vector3DotProduct(Vector3Subtract(origin, tri.A), faceNormal);
+	if (planeDistance < 0)
+	{
+		faceNormal = Vector3Negate(faceNormal);
+		planeDistance = -planeDistance;
+	}
+
+	// Only the face needs the sphere moving towards the plane. A sphere sliding along it, or
+	// leaving it, can still catch an edge or corner that's within reach.
+	float approach = Vector3DotProduct(direction, faceNormal);
+	if (approach < 0)
+	{
+		float faceT = fmaxf((planeDistance - radius) / -approach, 0.0f);
+		auto facePoint = Vector3Subtract(
+			Vector3Add(origin, Vector3Scale(direction, faceT)),
+			Vector3Scale(faceNormal, fminf(planeDistance, radius)));
+		if (PointInTriangle(facePoint, tri, windingNormal))
+		{
+			distance = faceT;
+			normal = faceNormal;
+			return true;
+		}
+	}
+
+	bool hit = false;
+	float best = FLT_MAX;
+
+	const Vector3 corners[3] = { tri.A, tri.B, tri.C };
+	for (int i = 0; i < 3; ++i)
+	{
+		float t;
+		if (IntersectEdgeCylinder(origin, direction, corners[i], corners[(i + 1) % 3], radius, t) && t < best)
+		{
+			best = t;
+			hit = true;
+		}
+		if (IntersectSphere(origin, direction, corners[i], radius, t) && t < best)
+		{
+			best = t;
+			hit = true;
+		}
+	}
+
+	if (!hit)
+		return false;
+
+	auto center = Vector3Add(origin, Vector3Scale(direction, best));
+	auto closest = tri.A;
+	float closestDistance = FLT_MAX;
+	for (int i = 0; i < 3; ++i)
+	{
+		auto point = ClosestPointOnSegment(center, corners[i], corners[(i + 1) % 3]);
+		float d = Vector3DistanceSqr(center, point);
+		if (d < closestDistance)
+		{
+			closestDistance = d;
+			closest = point;
+		}
+	}
+
+	distance = best;
+	normal = closestDistance > 1e-12f
+		? Vector3Normalize(Vector3Subtract(center, closest))
+		: faceNormal;
+	return true;
+}
+
+MeshBVH::MeshBVH()
+{
+	Transform = MatrixIdentity();
+	InverseTransform = MatrixIdentity();
+}
+
+void MeshBVH::Build(const Model& model)
+{
+	Triangles.clear();
+	Nodes.clear();
+
+	for (int m = 0; m < model.meshCount; ++m)
+	{
+		const Mesh& mesh = model.meshes[m];
+		if (mesh.vertices == nullptr)
+			continue;
+
+		auto getVertex = [&mesh](int index) {
+			return Vector3{ mesh.vertices[index * 3], mesh.vertices[index * 3 + 1], mesh.vertices[index * 3 + 2] };
+		};
+
+		for (int t = 0; t < mesh.triangleCount; ++t)
+		{
+			int i0 = mesh.indices ? mesh.indices[t * 3] : t * 3;
+			int i1 = mesh.indices ? mesh.indices[t * 3 + 1] : t * 3 + 1;
+			int i2 = mesh.indices ? mesh.indices[t * 3 + 2] : t * 3 + 2;
+			Triangles.push_back({ getVertex(i0), getVertex(i1), getVertex(i2) });
+		}
+	}
+
+	if (Triangles.empty())
+		return;
+
+	std::vector<Vector3> centroids;
+	centroids.reserve(Triangles.size());
+	for (auto& tri : Triangles)
+		centroids.push_back(Vector3Scale(Vector3Add(Vector3Add(tri.A, tri.B), tri.C), 1.0f / 3.0f));
+
+	// A binary tree never has more than 2n - 1 nodes, so this never reallocates during the build.
+	Nodes.reserve(Triangles.size() * 2);
+	BVHNode root = {};
+	root.LeftOrFirst = 0;
+	root.TriangleCount = (int)Triangles.size();
+	Nodes.push_back(root);
+
+	UpdateNodeBounds(0);
+	Subdivide(0, centroids, 0);
+}
+
+void MeshBVH::UpdateNodeBounds(int nodeIndex)
+{
+	auto& node = Nodes[nodeIndex];
+	node.Min = { FLT_MAX, FLT_MAX, FLT_MAX };
+	node.Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (int i = 0; i < node.TriangleCount; ++i)
+	{
+		auto& tri = Triangles[node.LeftOrFirst + i];
+		GrowBounds(node.Min, node.Max, tri.A);
+		GrowBounds(node.Min, node.Max, tri.B);
+		GrowBounds(node.Min, node.Max, tri.C);
+	}
+}
+
+void MeshBVH::Subdivide(int nodeIndex, std::vector<Vector3>& centroids, int depth)
+{
+	int first = Nodes[nodeIndex].LeftOrFirst;
+	int count = Nodes[nodeIndex].TriangleCount;
+	if (count <= MaxLeafTriangles || depth >= MaxTreeDepth)
+		return;
+
+	auto centroidMin = Vector3{ FLT_MAX, FLT_MAX, FLT_MAX };
+	auto centroidMax = Vector3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int i = first; i < first + count; ++i)
+		GrowBounds(centroidMin, centroidMax, centroids[i]);
+
+	// Binned SAH. Each axis gets split into evenly sized bins by centroid, and every boundary
+	// between bins is tried as a split plane.
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = FLT_MAX;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float axisMin = GetAxis(centroidMin, axis);
+		float axisMax = GetAxis(centroidMax, axis);
+		if (axisMax - axisMin <= 0)
+			continue;
+
+		Bin bins[BinCount];
+		float scale = BinCount / (axisMax - axisMin);
+		for (int i = first; i < first + count; ++i)
+		{
+			int binIndex = (int)((GetAxis(centroids[i], axis) - axisMin) * scale);
+			binIndex = binIndex < BinCount - 1 ? binIndex : BinCount - 1;
+			auto& bin = bins[binIndex];
+			auto& tri = Triangles[i];
+			GrowBounds(bin.Min, bin.Max, tri.A);
+			GrowBounds(bin.Min, bin.Max, tri.B);
+			GrowBounds(bin.Min, bin.Max, tri.C);
+			bin.Count++;
+		}
+
+		float leftArea[BinCount - 1];
+		int leftCount[BinCount - 1];
+		auto boundsMin = Vector3{ FLT_MAX, FLT_MAX, FLT_MAX };
+		auto boundsMax = Vector3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		int runningCount = 0;
+		for (int i = 0; i < BinCount - 1; ++i)
+		{
+			runningCount += bins[i].Count;
+			if (bins[i].Count > 0)
+			{
+				GrowBounds(boundsMin, boundsMax, bins[i].Min);
+				GrowBounds(boundsMin, boundsMax, bins[i].Max);
+			}
+			leftCount[i] = runningCount;
+			leftArea[i] = runningCount > 0 ? SurfaceArea(boundsMin, boundsMax) : 0;
+		}
+
+		boundsMin = Vector3{ FLT_MAX, FLT_MAX, FLT_MAX };
+		boundsMax = Vector3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		runningCount = 0;
+		for (int i = BinCount - 1; i > 0; --i)
+		{
+			runningCount += bins[i].Count;
+			if (bins[i].Count > 0)
+			{
+				GrowBounds(boundsMin, boundsMax, bins[i].Min);
+				GrowBounds(boundsMin, boundsMax, bins[i].Max);
+			}
+			float rightArea = runningCount > 0 ? SurfaceArea(boundsMin, boundsMax) : 0;
+			float cost = leftCount[i - 1] * leftArea[i - 1] + runningCount * rightArea;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	// Splitting is only worthwhile when it's cheaper than testing every triangle in this node.
+	float leafCost = count * SurfaceArea(Nodes[nodeIndex].Min, Nodes[nodeIndex].Max);
+	if (bestAxis < 0 || bestCost >= leafCost)
+		return;
+
+	float axisMin = GetAxis(centroidMin, bestAxis);
+	float scale = BinCount / (GetAxis(centroidMax, bestAxis) - axisMin);
+	int i = first;
+	int j = first + count - 1;
+	while (i <= j)
+	{
+		int binIndex = (int)((GetAxis(centroids[i], bestAxis) - axisMin) * scale);
+		binIndex = binIndex < BinCount - 1 ? binIndex : BinCount - 1;
+		if (binIndex < bestSplit)
+		{
+			i++;
+		}
+		else
+		{
+			std::swap(Triangles[i], Triangles[j]);
+			std::swap(centroids[i], centroids[j]);
+			j--;
+		}
+	}
+
+	int leftCount = i - first;
+	if (leftCount == 0 || leftCount == count)
+		return;
+
+	int leftIndex = (int)Nodes.size();
+	BVHNode left = {};
+	left.LeftOrFirst = first;
+	left.TriangleCount = leftCount;
+	BVHNode right = {};
+	right.LeftOrFirst = i;
+	right.TriangleCount = count - leftCount;
+	Nodes.push_back(left);
+	Nodes.push_back(right);
+
+	Nodes[nodeIndex].LeftOrFirst = leftIndex;
+	Nodes[nodeIndex].TriangleCount = 0;
+
+	UpdateNodeBounds(leftIndex);
+	UpdateNodeBounds(leftIndex + 1);
+	Subdivide(leftIndex, centroids, depth + 1);
+	Subdivide(leftIndex + 1, centroids, depth + 1);
+}
+
+void MeshBVH::LoadOrBuild(const char* modelPath, const Model& model)
+{
+	auto cachePath = std::string(modelPath) + ".bvh";
+	long modTime = GetFileModTime(modelPath);
+
+	if (LoadCache(cachePath.c_str(), modTime))
+	{
+		TraceLog(LOG_INFO, "BVH: [%s] Loaded %d triangles, %d nodes from cache",
+			modelPath, GetTriangleCount(), GetNodeCount());
+		return;
+	}
+
+	Build(model);
+	SaveCache(cachePath.c_str(), modTime);
+	TraceLog(LOG_INFO, "BVH: [%s] Built %d triangles, %d nodes",
+		modelPath, GetTriangleCount(), GetNodeCount());
+}
+
+bool MeshBVH::LoadCache(const char* cachePath, long sourceModTime)
+{
+	if (!FileExists(cachePath))
+		return false;
+
+	unsigned int size = 0;
+	unsigned char* data = LoadFileData(cachePath, &size);
+	if (data == nullptr)
+		return false;
+
+	bool valid = false;
+	CacheHeader header;
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+		size_t expectedSize = sizeof(header)
+			+ header.TriangleCount * sizeof(BVHTriangle)
+			+ header.NodeCount * sizeof(BVHNode);
+
+		valid = memcmp(header.Magic, CacheMagic, sizeof(CacheMagic)) == 0
+			&& header.Version == CacheVersion
+			&& header.SourceModTime == sourceModTime
+			&& header.TriangleCount > 0
+			&& header.NodeCount > 0
+			&& size == expectedSize;
+	}
+
+	if (valid)
+	{
+		Triangles.resize(header.TriangleCount);
+		Nodes.resize(header.NodeCount);
+		auto cursor = data + sizeof(header);
+		memcpy(Triangles.data(), cursor, Triangles.size() * sizeof(BVHTriangle));
+		cursor += Triangles.size() * sizeof(BVHTriangle);
+		memcpy(Nodes.data(), cursor, Nodes.size() * sizeof(BVHNode));
+	}
+
+	UnloadFileData(data);
+	return valid;
+}
+
+void MeshBVH::SaveCache(const char* cachePath, long sourceModTime) const
+{
+	if (Triangles.empty())
+		return;
+
+	CacheHeader header;
+	memcpy(header.Magic, CacheMagic, sizeof(CacheMagic));
+	header.Version = CacheVersion;
+	header.SourceModTime = sourceModTime;
+	header.TriangleCount = (int)Triangles.size();
+	header.NodeCount = (int)Nodes.size();
+
+	std::vector<unsigned char> data(sizeof(header)
+		+ Triangles.size() * sizeof(BVHTriangle)
+		+ Nodes.size() * sizeof(BVHNode));
+	auto cursor = data.data();
+	memcpy(cursor, &header, sizeof(header));
+	cursor += sizeof(header);
+	memcpy(cursor, Triangles.data(), Triangles.size() * sizeof(BVHTriangle));
+	cursor += Triangles.size() * sizeof(BVHTriangle);
+	memcpy(cursor, Nodes.data(), Nodes.size() * sizeof(BVHNode));
+
+	if (!SaveFileData(cachePath, data.data(), (unsigned int)data.size()))
+		TraceLog(LOG_WARNING, "BVH: [%s] Failed to write cache", cachePath);
+}
+
+void MeshBVH::SetTransform(Matrix transform)
+{
+	Transform = transform;
+	InverseTransform = MatrixInvert(transform);
+}
+
+Vector3 MeshBVH::ToLocalPoint(Vector3 point) const
+{
+	return Vector3Transform(point, InverseTransform);
+}
+
+Vector3 MeshBVH::ToLocalDirection(Vector3 direction) const
+{
+	return TransformDirection(direction, InverseTransform);
+}
+
+MeshHit MeshBVH::ToWorld(MeshHit hit) const
+{
+	if (hit.Hit)
+	{
+		hit.Point = Vector3Transform(hit.Point, Transform);
+		hit.Normal = TransformDirection(hit.Normal, Transform);
+	}
+	return hit;
+}
+
+MeshHit MeshBVH::Raycast(Vector3 origin, Vector3 direction, float maxDistance) const
+{
+	MeshHit result;
+	if (Nodes.empty())
+		return result;
+
+	origin = ToLocalPoint(origin);
+	direction = ToLocalDirection(direction);
+	auto invDirection = SafeInverse(direction);
+
+	float closest = maxDistance;
+	int hitTriangle = -1;
+
+	int stack[MaxStackDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const auto& node = Nodes[stack[--stackSize]];
+		if (IntersectAABB(origin, invDirection, node.Min, node.Max, closest) == FLT_MAX)
+			continue;
+
+		if (node.TriangleCount > 0)
+		{
+			for (int i = node.LeftOrFirst; i < node.LeftOrFirst + node.TriangleCount; ++i)
+			{
+				float t;
+				if (IntersectTriangle(origin, direction, Triangles[i], t) && t < closest)
+				{
+					closest = t;
+					hitTriangle = i;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first so that the far one can usually be culled by distance.
+		int nearChild = node.LeftOrFirst;
+		int farChild = node.LeftOrFirst + 1;
+		float nearT = IntersectAABB(origin, invDirection, Nodes[nearChild].Min, Nodes[nearChild].Max, closest);
+		float farT = IntersectAABB(origin, invDirection, Nodes[farChild].Min, Nodes[farChild].Max, closest);
+		if (farT < nearT)
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearT, farT);
+		}
+
+		assert(stackSize + 2 <= MaxStackDepth && "BVH is deeper than the traversal stack");
+		if (farT != FLT_MAX)
+			stack[stackSize++] = farChild;
+		if (nearT != FLT_MAX)
+			stack[stackSize++] = nearChild;
+	}
+
+	if (hitTriangle < 0)
+		return result;
+
+	const auto& tri = Triangles[hitTriangle];
+	auto normal = Vector3Normalize(Vector3CrossProduct(
+		Vector3Subtract(tri.B, tri.A),
+		Vector3Subtract(tri.C, tri.A)));
+	if (Vector3DotProduct(normal, direction) > 0)
+		normal = Vector3Negate(normal);
+
+	result.Hit = true;
+	result.Distance = closest;
+	result.Point = Vector3Add(origin, Vector3Scale(direction, closest));
+	result.Normal = normal;
+	return ToWorld(result);
+}
+
+MeshHit MeshBVH::SweepSphere(Vector3 from, Vector3 to, float radius) const
+{
+	MeshHit result;
+	if (Nodes.empty())
+		return result;
+
+	from = ToLocalPoint(from);
+	to = ToLocalPoint(to);
+
+	auto movement = Vector3Subtract(to, from);
+	float length = Vector3Length(movement);
+	if (length < 1e-6f)
+		return result;
+
+	auto direction = Vector3Scale(movement, 1.0f / length);
+	auto invDirection = SafeInverse(direction);
+	auto expand = Vector3{ radius, radius, radius };
+
+	// Distances are allowed up to the end of the sweep, inclusive.
+	float closest = length + 1e-5f;
+	Vector3 closestNormal = { 0, 0, 0 };
+	bool hit = false;
+
+	int stack[MaxStackDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const auto& node = Nodes[stack[--stackSize]];
+		auto min = Vector3Subtract(node.Min, expand);
+		auto max = Vector3Add(node.Max, expand);
+		if (IntersectAABB(from, invDirection, min, max, closest) == FLT_MAX)
+			continue;
+
+		if (node.TriangleCount > 0)
+		{
+			for (int i = node.LeftOrFirst; i < node.LeftOrFirst + node.TriangleCount; ++i)
+			{
+				float t;
+				Vector3 normal;
+				if (SweepSphereTriangle(from, direction, radius, Triangles[i], t, normal) && t < closest)
+				{
+					closest = t;
+					closestNormal = normal;
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		assert(stackSize + 2 <= MaxStackDepth && "BVH is deeper than the traversal stack");
+		stack[stackSize++] = node.LeftOrFirst + 1;
+		stack[stackSize++] = node.LeftOrFirst;
+	}
+
+	if (!hit)
+		return result;
+
+	result.Hit = true;
+	result.Distance = fminf(closest, length);
+	result.Point = Vector3Add(from, Vector3Scale(direction, result.Distance));
+	result.Normal = closestNormal;
+	return ToWorld(result);
+}
+
+int MeshBVH::GetTriangleCount() const
+{
+	return (int)Triangles.size();
+}
+
+int MeshBVH::GetNodeCount() const
+{
+	return (int)Nodes.size();
+}
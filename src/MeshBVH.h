@@ -0,0 +1,90 @@
+#pragma once
+
+#include <raylib.h>
+#include <vector>
+
+struct BVHTriangle
+{
+	Vector3 A;
+	Vector3 B;
+	Vector3 C;
+};
+
+struct BVHNode
+{
+	Vector3 Min;
+	// Leaves store the index of their first triangle here, interior nodes store the index of
+	// their left child. The right child is always stored directly after the left child.
+	int LeftOrFirst;
+	Vector3 Max;
+	// Zero for interior nodes.
+	int TriangleCount;
+};
+
+struct MeshHit
+{
+	bool Hit = false;
+	float Distance = 0;
+	Vector3 Point = { 0, 0, 0 };
+	Vector3 Normal = { 0, 0, 0 };
+};
+
+/// <summary>
+/// Bounding volume hierarchy over the triangles of a static model, used for collision and
+/// ray queries against level geometry. Queries walk the tree, so they stay cheap even when the
+/// mesh has a lot of triangles.
+/// </summary>
+class MeshBVH
+{
+public:
+	MeshBVH();
+
+	/// <summary>
+	/// Builds the hierarchy from every mesh in the model using the surface area heuristic.
+	/// Triangles are stored in model space, see SetTransform().
+	/// </summary>
+	void Build(const Model& model);
+
+	/// <summary>
+	/// Loads the hierarchy from the cache file next to the model ("modelPath.bvh"). If the cache
+	/// is missing or older than the model, the hierarchy is built and the cache is rewritten.
+	/// </summary>
+	void LoadOrBuild(const char* modelPath, const Model& model);
+
+	/// <summary>
+	/// Places the model in the world. Only rotation and translation are supported.
+	/// </summary>
+	void SetTransform(Matrix transform);
+
+	/// <summary>
+	/// Finds the closest triangle hit by the ray within maxDistance. Direction must be normalized.
+	/// </summary>
+	MeshHit Raycast(Vector3 origin, Vector3 direction, float maxDistance) const;
+
+	/// <summary>
+	/// Moves a sphere from one point to another and finds the first triangle it touches. On a hit,
+	/// Point is the center of the sphere at the moment of contact and Normal points away from
+	/// the surface. Spheres already touching a surface only collide when moving into it.
+	/// </summary>
+	MeshHit SweepSphere(Vector3 from, Vector3 to, float radius) const;
+
+	int GetTriangleCount() const;
+	int GetNodeCount() const;
+
+private:
+	std::vector<BVHTriangle> Triangles;
+	std::vector<BVHNode> Nodes;
+
+	Matrix Transform;
+	Matrix InverseTransform;
+
+	void UpdateNodeBounds(int nodeIndex);
+	void Subdivide(int nodeIndex, std::vector<Vector3>& centroids, int depth);
+
+	bool LoadCache(const char* cachePath, long sourceModTime);
+	void SaveCache(const char* cachePath, long sourceModTime) const;
+
+	Vector3 ToLocalPoint(Vector3 point) const;
+	Vector3 ToLocalDirection(Vector3 direction) const;
+	MeshHit ToWorld(MeshHit hit) const;
+};
@@ -0,0 +1,250 @@
+#include "RenderStats.h"
+
+#include <rlgl.h>
+#include <cstdio>
+
+static const int PassCount = (int)RenderPass::Count;
+
+// Same size as rlgl's default batch, so swapping it in doesn't change when rlgl flushes.
+static const int BatchBufferCount = 1;
+static const int BatchBufferElements = 8192;
+
+// raylib's MAX_MATERIAL_MAPS. DrawMesh() binds every map of the material that has a texture.
+static const int MaxMaterialMaps = 12;
+
+static rlRenderBatch Batch;
+static bool HasBatch = false;
+
+static RenderPass CurrentPass = RenderPass::Opaque;
+static RenderPassStats CurrentFrame[PassCount];
+static RenderPassStats LastFrame[PassCount];
+static long long FrameIndex = 0;
+
+// Mirrors rlgl's blend mode, which it only changes (and flushes for) when it differs.
+static int CurrentBlendMode = BLEND_ALPHA;
+
+static FILE* CsvFile = nullptr;
+
+static RenderPassStats& GetCurrentStats()
+{
+	return CurrentFrame[(int)CurrentPass];
+}
+
+// Counts what the next flush of the batch will submit. Must be called right before anything
+// that flushes it.
+static void RecordPendingBatch()
+{
+	if (!HasBatch)
+		return;
+
+	unsigned int vertices = 0;
+	for (int i = 0; i < Batch.drawCounter; ++i)
+		vertices += Batch.draws[i].vertexCount;
+
+	// rlgl doesn't submit anything for an empty batch.
+	if (vertices == 0)
+		return;
+
+	auto& stats = GetCurrentStats();
+	stats.BatchFlushes++;
+	for (int i = 0; i < Batch.drawCounter; ++i)
+	{
+		const auto& draw = Batch.draws[i];
+		stats.DrawCalls++;
+		stats.TextureBinds++;
+		stats.Vertices += draw.vertexCount;
+
+		if (draw.mode == RL_TRIANGLES)
+			stats.Triangles += draw.vertexCount / 3;
+		else if (draw.mode == RL_QUADS)
+			stats.Triangles += draw.vertexCount / 4 * 2;
+	}
+}
+
+void RenderStats::Init()
+{
+	if (HasBatch)
+		return;
+
+	Batch = rlLoadRenderBatch(BatchBufferCount, BatchBufferElements);
+	rlSetRenderBatchActive(&Batch);
+	HasBatch = true;
+}
+
+void RenderStats::Shutdown()
+{
+	CloseCsv();
+
+	if (!HasBatch)
+		return;
+
+	// Passing null puts rlgl's default batch back.
+	rlSetRenderBatchActive(nullptr);
+	rlUnloadRenderBatch(Batch);
+	HasBatch = false;
+}
+
+void RenderStats::BeginPass(RenderPass pass)
+{
+	FlushBatch();
+	CurrentPass = pass;
+}
+
+void RenderStats::EndPass()
+{
+	FlushBatch();
+}
+
+void RenderStats::EndFrame()
+{
+	if (CsvFile != nullptr)
+	{
+		float frameMilliseconds = GetFrameTime() * 1000;
+		for (int i = 0; i < PassCount; ++i)
+		{
+			const auto& stats = CurrentFrame[i];
+			fprintf(CsvFile, "%lld,%s,%.3f,%u,%u,%u,%u,%u,%u,%u\n",
+				FrameIndex, GetPassName((RenderPass)i), frameMilliseconds,
+				stats.DrawCalls, stats.BatchFlushes, stats.Vertices, stats.Triangles,
+				stats.BlendChanges, stats.DepthChanges, stats.TextureBinds);
+		}
+	}
+
+	for (int i = 0; i < PassCount; ++i)
+	{
+		LastFrame[i] = CurrentFrame[i];
+		CurrentFrame[i] = RenderPassStats();
+	}
+
+	FrameIndex++;
+}
+
+bool RenderStats::OpenCsv(const char* path)
+{
+	CloseCsv();
+
+#if defined(_MSC_VER)
+	// MSVC's SDL checks reject plain fopen().
+	if (fopen_s(&CsvFile, path, "w") != 0)
+		CsvFile = nullptr;
+#else
+	CsvFile = fopen(path, "w");
+#endif
+	if (CsvFile == nullptr)
+	{
+		TraceLog(LOG_WARNING, "RENDER: [%s] Failed to open stats file", path);
+		return false;
+	}
+
+	fprintf(CsvFile, "frame,pass,frame_ms,draw_calls,batch_flushes,vertices,triangles,blend_changes,depth_changes,texture_binds\n");
+	TraceLog(LOG_INFO, "RENDER: [%s] Writing render stats", path);
+	return true;
+}
+
+void RenderStats::CloseCsv()
+{
+	if (CsvFile == nullptr)
+		return;
+
+	fclose(CsvFile);
+	CsvFile = nullptr;
+}
+
+RenderPassStats RenderStats::GetFrameStats(RenderPass pass)
+{
+	return LastFrame[(int)pass];
+}
+
+RenderPassStats RenderStats::GetFrameTotal()
+{
+	RenderPassStats total;
+	for (int i = 0; i < PassCount; ++i)
+	{
+		total.DrawCalls += LastFrame[i].DrawCalls;
+		total.BatchFlushes += LastFrame[i].BatchFlushes;
+		total.Vertices += LastFrame[i].Vertices;
+		total.Triangles += LastFrame[i].Triangles;
+		total.BlendChanges += LastFrame[i].BlendChanges;
+		total.DepthChanges += LastFrame[i].DepthChanges;
+		total.TextureBinds += LastFrame[i].TextureBinds;
+	}
+	return total;
+}
+
+const char* RenderStats::GetPassName(RenderPass pass)
+{
+	switch (pass)
+	{
+		case RenderPass::Opaque: return "Opaque";
+		case RenderPass::Transparent: return "Transparent";
+		case RenderPass::Overlay: return "Overlay";
+		default: return "Unknown";
+	}
+}
+
+void RenderStats::FlushBatch()
+{
+	RecordPendingBatch();
+	rlDrawRenderBatchActive();
+}
+
+void RenderStats::BeginBlendMode(int mode)
+{
+	if (mode == CurrentBlendMode)
+		return;
+
+	// Changing the blend mode flushes the batch first.
+	RecordPendingBatch();
+	::BeginBlendMode(mode);
+
+	CurrentBlendMode = mode;
+	GetCurrentStats().BlendChanges++;
+}
+
+void RenderStats::EndBlendMode()
+{
+	BeginBlendMode(BLEND_ALPHA);
+}
+
+void RenderStats::SetDepthMask(bool enabled)
+{
+	if (enabled)
+		rlEnableDepthMask();
+	else
+		rlDisableDepthMask();
+
+	GetCurrentStats().DepthChanges++;
+}
+
+void RenderStats::SetDepthTest(bool enabled)
+{
+	if (enabled)
+		rlEnableDepthTest();
+	else
+		rlDisableDepthTest();
+
+	GetCurrentStats().DepthChanges++;
+}
+
+void RenderStats::DrawModel(const Model& model, Vector3 position, float scale, Color tint)
+{
+	// Meshes bypass the batch and are drawn straight away, one draw call each.
+	auto& stats = GetCurrentStats();
+	for (int i = 0; i < model.meshCount; ++i)
+	{
+		const auto& mesh = model.meshes[i];
+		const auto& material = model.materials[model.meshMaterial[i]];
+
+		stats.DrawCalls++;
+		stats.Vertices += mesh.vertexCount;
+		stats.Triangles += mesh.triangleCount;
+
+		for (int map = 0; map < MaxMaterialMaps; ++map)
+		{
+			if (material.maps[map].texture.id > 0)
+				stats.TextureBinds++;
+		}
+	}
+
+	::DrawModel(model, position, scale, tint);
+}
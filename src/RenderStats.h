@@ -0,0 +1,77 @@
+#pragma once
+
+#include <raylib.h>
+
+enum class RenderPass
+{
+	Opaque,
+	Transparent,
+	Overlay,
+	Count
+};
+
+struct RenderPassStats
+{
+	unsigned int DrawCalls = 0;
+	unsigned int BatchFlushes = 0;
+	unsigned int Vertices = 0;
+	unsigned int Triangles = 0;
+	unsigned int BlendChanges = 0;
+	unsigned int DepthChanges = 0;
+	unsigned int TextureBinds = 0;
+};
+
+/// <summary>
+/// Counts what the renderer submits to rlgl, per pass and per frame. Immediate mode drawing
+/// (lines, triangles, text) is counted from rlgl's render batch whenever it gets flushed, and
+/// models are counted per mesh as they're drawn. Everything is counted on the CPU side, so the
+/// figures are the same on any GL driver, including software ones like Mesa's llvmpipe.
+///
+/// Only drawing and state changes that go through the functions below are seen. rlgl also
+/// flushes on its own when the batch fills up, and anything drawn before such a flush is missed.
+/// </summary>
+class RenderStats
+{
+public:
+	/// <summary>
+	/// Call after the window is created. Swaps in a render batch owned by the stats, so that its
+	/// draw calls can be read back before each flush.
+	/// </summary>
+	static void Init();
+	static void Shutdown();
+
+	/// <summary>
+	/// Flushes whatever's pending into the previous pass and starts counting into this one.
+	/// </summary>
+	static void BeginPass(RenderPass pass);
+	static void EndPass();
+
+	/// <summary>
+	/// Closes off the current frame, and writes it out if a CSV file is open. Call once per
+	/// rendered frame, after EndDrawing().
+	/// </summary>
+	static void EndFrame();
+
+	/// <summary>
+	/// Writes a row per pass for every frame from here on. Returns false if the file couldn't be
+	/// opened.
+	/// </summary>
+	static bool OpenCsv(const char* path);
+	static void CloseCsv();
+
+	/// <summary>
+	/// Counts from the last completed frame.
+	/// </summary>
+	static RenderPassStats GetFrameStats(RenderPass pass);
+	static RenderPassStats GetFrameTotal();
+
+	static const char* GetPassName(RenderPass pass);
+
+	// Counted versions of the raylib and rlgl calls that submit geometry or change state.
+	static void FlushBatch();
+	static void BeginBlendMode(int mode);
+	static void EndBlendMode();
+	static void SetDepthMask(bool enabled);
+	static void SetDepthTest(bool enabled);
+	static void DrawModel(const Model& model, Vector3 position, float scale, Color tint);
+};
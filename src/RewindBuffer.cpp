@@ -0,0 +1,192 @@
+#include "RewindBuffer.h"
+
+#include <raylib.h>
+#include <cstdint>
+#include <cstring>
+
+// State is compared and encoded a word at a time. The encoding is a series of runs, each a
+// header word (count of unchanged words in the low half, count of changed words in the high
+// half) followed by the XOR of each changed word.
+static const size_t WordSize = sizeof(uint64_t);
+
+static uint64_t LoadWord(const unsigned char* data)
+{
+	uint64_t word;
+	memcpy(&word, data, WordSize);
+	return word;
+}
+
+static void StoreWord(unsigned char* data, uint64_t word)
+{
+	memcpy(data, &word, WordSize);
+}
+
+RewindBuffer::RewindBuffer(int maxTicks, float deltaRatio)
+{
+	DeltaRatio = deltaRatio;
+	Entries.resize(maxTicks);
+}
+
+void RewindBuffer::Record(const unsigned char* state, size_t size)
+{
+	size_t wordCount = (size + WordSize - 1) / WordSize;
+
+	// Worst case is every other word changing, where each changed word needs its own header.
+	size_t maxEncodedSize = (wordCount + 1) * WordSize;
+
+	// Deltas only make sense between states with the same layout, so when the size changes (or on
+	// the first call) the history starts over from this state.
+	if (size != StateSize)
+	{
+		Clear();
+		StateSize = size;
+		Current.assign(wordCount * WordSize, 0);
+		memcpy(Current.data(), state, size);
+
+		// Room for the expected deltas, plus one worst case delta so that any single tick fits.
+		Encoded.resize(maxEncodedSize);
+		Ring.resize((size_t)(Current.size() * Entries.size() * DeltaRatio) + maxEncodedSize);
+		Ring.shrink_to_fit();
+		TraceLog(LOG_INFO, "REWIND: Reserved %zu KB for %d ticks of %zu byte states",
+			Ring.size() / 1024, (int)Entries.size(), size);
+		return;
+	}
+
+	// Encoding works on whole words, so a partial last word gets padded out with zeros.
+	if (size % WordSize != 0)
+	{
+		Padded.assign(wordCount * WordSize, 0);
+		memcpy(Padded.data(), state, size);
+		state = Padded.data();
+	}
+
+	// Encode the difference from the current state, updating the current state as it goes.
+	unsigned char* out = Encoded.data();
+	unsigned char* current = Current.data();
+	size_t encodedSize = 0;
+	size_t i = 0;
+	while (i < wordCount)
+	{
+		uint64_t unchanged = 0;
+		while (i < wordCount && LoadWord(state + i * WordSize) == LoadWord(current + i * WordSize))
+		{
+			unchanged++;
+			i++;
+		}
+
+		size_t header = encodedSize;
+		encodedSize += WordSize;
+
+		uint64_t changed = 0;
+		while (i < wordCount)
+		{
+			uint64_t next = LoadWord(state + i * WordSize);
+			uint64_t previous = LoadWord(current + i * WordSize);
+			if (next == previous)
+				break;
+
+			StoreWord(out + encodedSize, next ^ previous);
+			StoreWord(current + i * WordSize, next);
+			encodedSize += WordSize;
+			changed++;
+			i++;
+		}
+
+		StoreWord(out + header, unchanged | (changed << 32));
+	}
+
+	if (EntryCount == (int)Entries.size())
+		DropOldest();
+
+	size_t offset = WriteOffset + encodedSize <= Ring.size() ? WriteOffset : 0;
+	while (EntryCount > 0 && OverlapsAnyEntry(offset, encodedSize))
+		DropOldest();
+
+	memcpy(Ring.data() + offset, Encoded.data(), encodedSize);
+
+	int newest = (OldestEntry + EntryCount) % (int)Entries.size();
+	Entries[newest] = { offset, encodedSize };
+	EntryCount++;
+	UsedBytes += encodedSize;
+	WriteOffset = offset + encodedSize;
+}
+
+bool RewindBuffer::StepBack()
+{
+	if (EntryCount == 0)
+		return false;
+
+	int newest = (OldestEntry + EntryCount - 1) % (int)Entries.size();
+	const auto& entry = Entries[newest];
+
+	// XOR is its own inverse, so applying the delta to the newer state gives back the older one.
+	const unsigned char* in = Ring.data() + entry.Offset;
+	unsigned char* current = Current.data();
+	size_t read = 0;
+	size_t i = 0;
+	while (read < entry.Size)
+	{
+		uint64_t header = LoadWord(in + read);
+		read += WordSize;
+
+		i += header & 0xFFFFFFFF;
+		uint64_t changed = header >> 32;
+		for (uint64_t c = 0; c < changed; ++c)
+		{
+			StoreWord(current + i * WordSize, LoadWord(current + i * WordSize) ^ LoadWord(in + read));
+			read += WordSize;
+			i++;
+		}
+	}
+
+	EntryCount--;
+	UsedBytes -= entry.Size;
+	WriteOffset = entry.Offset;
+	return true;
+}
+
+void RewindBuffer::Clear()
+{
+	OldestEntry = 0;
+	EntryCount = 0;
+	UsedBytes = 0;
+	WriteOffset = 0;
+}
+
+const unsigned char* RewindBuffer::GetState() const
+{
+	return Current.data();
+}
+
+size_t RewindBuffer::GetStateSize() const
+{
+	return StateSize;
+}
+
+int RewindBuffer::GetTickCount() const
+{
+	return EntryCount;
+}
+
+size_t RewindBuffer::GetUsedBytes() const
+{
+	return UsedBytes;
+}
+
+void RewindBuffer::DropOldest()
+{
+	UsedBytes -= Entries[OldestEntry].Size;
+	OldestEntry = (OldestEntry + 1) % (int)Entries.size();
+	EntryCount--;
+}
+
+bool RewindBuffer::OverlapsAnyEntry(size_t offset, size_t size) const
+{
+	for (int i = 0; i < EntryCount; ++i)
+	{
+		const auto& entry = Entries[(OldestEntry + i) % (int)Entries.size()];
+		if (offset < entry.Offset + entry.Size && entry.Offset < offset + size)
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Keeps a history of serialized simulation state, one entry per tick, that can be stepped
+/// backwards through. Only the latest state is stored in full. Every older tick is stored as the
+/// XOR of it and the tick after it, run length encoded, which is mostly zeros since little
+/// changes from one tick to the next. Entries live in a single ring of memory, and the oldest
+/// are dropped to make room.
+/// </summary>
+class RewindBuffer
+{
+public:
+	/// <summary>
+	/// The ring is sized from the state once the first one is recorded, so that maxTicks fit as
+	/// long as each tick's delta averages no more than deltaRatio of the state's size. If deltas
+	/// turn out larger, the oldest ticks are dropped sooner and the history is shorter.
+	/// </summary>
+	RewindBuffer(int maxTicks, float deltaRatio);
+
+	/// <summary>
+	/// Adds the state after a tick. If the size of the state changes, the history is cleared and
+	/// the ring is resized, which is the only time recording allocates.
+	/// </summary>
+	void Record(const unsigned char* state, size_t size);
+
+	/// <summary>
+	/// Rewinds one tick, making the previously recorded state current. Returns false when there
+	/// is no older state left.
+	/// </summary>
+	bool StepBack();
+
+	void Clear();
+
+	/// <summary>
+	/// The most recently recorded state, or the one stepped back to.
+	/// </summary>
+	const unsigned char* GetState() const;
+	size_t GetStateSize() const;
+
+	int GetTickCount() const;
+	size_t GetUsedBytes() const;
+
+private:
+	struct Entry
+	{
+		size_t Offset;
+		size_t Size;
+	};
+
+	// The latest state, padded to a whole number of words.
+	std::vector<unsigned char> Current;
+	size_t StateSize = 0;
+	std::vector<unsigned char> Padded;
+
+	// Each delta is encoded here first, so that only as much of the ring as it really needs is
+	// reclaimed for it.
+	std::vector<unsigned char> Encoded;
+
+	float DeltaRatio;
+	std::vector<unsigned char> Ring;
+	std::vector<Entry> Entries;
+	int OldestEntry = 0;
+	int EntryCount = 0;
+	size_t WriteOffset = 0;
+	size_t UsedBytes = 0;
+
+	void DropOldest();
+	bool OverlapsAnyEntry(size_t offset, size_t size) const;
+};
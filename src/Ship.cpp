@@ -1,27 +1,41 @@
 #include "Ship.h"
 
 #include "MathUtils.h"
+#include "MeshBVH.h"
+#include "RenderStats.h"
+#include "StateStream.h"
+#include "TextureAtlas.h"
 
 #include <vector>
-#include <rlgl.h>
 
 static const float RungDistance = 2.0f;
 static const float RungTimeToLive = 2.0f;
 
-Ship::Ship(const char* modelPath, const char* texturePath, Color color)
-{
-	Texture2D texture = LoadTexture(texturePath);
-	texture.mipmaps = 0;
-	SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+// The trail clock is wound back by this much whenever it gets past it, so that it never grows
+// large enough to lose float precision.
+static const float TrailTimeRebase = 1000.0f;
+
+// How far the ship is kept from surfaces after a collision, so the next sweep doesn't start
+// out already touching them.
+static const float CollisionSkin = 0.01f;
+static const int MaxCollisionIterations = 3;
 
+Ship::Ship(const char* modelPath, const TextureAtlas& atlas, const char* texturePath, Color color)
+{
+	// If the atlas can't be used, the model keeps the texture it loaded with.
 	ShipModel = LoadModel(modelPath);
-	ShipModel.materials[0].maps[MaterialMapIndex::MATERIAL_MAP_ALBEDO].texture = texture;
+	if (!atlas.ApplyToModel(ShipModel, texturePath))
+		TraceLog(LOG_WARNING, "ATLAS: [%s] Using the model's own texture", modelPath);
 
 	Rotation = QuaternionFromEuler(1, 2, 0);
 
 	ShipColor = color;
 
 	LastRungPosition = Position;
+	for (int i = 0; i < TrailRungCount; ++i)
+		Rungs[i] = { Position, Position, -RungTimeToLive };
+
+	UpdateModelTransform();
 }
 
 Ship::~Ship()
@@ -29,7 +43,7 @@ Ship::~Ship()
 	UnloadModel(ShipModel);
 }
 
-void Ship::Update(float deltaTime)
+void Ship::UpdateMovement(float deltaTime, const MeshBVH* world)
 {
 	// Give the ship some momentum when accelerating.
 	SmoothForward = SmoothDamp(SmoothForward, InputForward, ThrottleResponse, deltaTime);
@@ -51,99 +65,237 @@ void Ship::Update(float deltaTime)
 		Vector3Scale(GetLeft(), MaxSpeed * .5f * SmoothLeft));
 
 	Velocity = SmoothDamp(Velocity, targetVelocity, 2.5, deltaTime);
-	Position = Vector3Add(Position, Vector3Scale(Velocity, deltaTime));
+
+	auto movement = Vector3Scale(Velocity, deltaTime);
+	if (world != nullptr)
+		movement = MoveAndCollide(*world, movement);
+	Position = Vector3Add(Position, movement);
 
 	// Give the ship some inertia when turning. These are the pilot controlled rotations.
 	SmoothPitchDown = SmoothDamp(SmoothPitchDown, InputPitchDown, TurnResponse, deltaTime);
 	SmoothRollRight = SmoothDamp(SmoothRollRight, InputRollRight, TurnResponse, deltaTime);
 	SmoothYawLeft = SmoothDamp(SmoothYawLeft, InputYawLeft, TurnResponse, deltaTime);
 
-	RotateLocalEuler( { 0, 0, 1 }, SmoothRollRight * TurnRate * deltaTime);
-	RotateLocalEuler({ 1, 0, 0 }, SmoothPitchDown * TurnRate * deltaTime);
-	RotateLocalEuler({ 0, 1, 0 }, SmoothYawLeft * TurnRate * deltaTime);
+	// Auto-roll to align to horizon
+	float autoRoll = 0;
+	if (fabs(GetForward().y) < 0.8)
+		autoRoll = GetRight().y * .5f;
 
 	//// Auto-roll from yaw
 	//// Movement like a 3D space sim. This only feels good if there's no horizon auto-align.
-	//RotateLocalEuler({ 0, 0, -1 }, SmoothYawLeft * TurnRate * .5f * deltaTime);
-
-	// Auto-roll to align to horizon
-	if (fabs(GetForward().y) < 0.8)
-	{
-		float autoSteerInput = GetRight().y;
-		RotateLocalEuler({ 0, 0, 1 }, autoSteerInput * TurnRate * .5f * deltaTime);
-	}
+	//autoRoll -= SmoothYawLeft * .5f;
+
+	// Pitch, yaw and roll are combined into one angular velocity and applied in a single step.
+	float turnRate = TurnRate * DEG2RAD;
+	AngularVelocity = {
+		SmoothPitchDown * turnRate,
+		SmoothYawLeft * turnRate,
+		(SmoothRollRight + autoRoll) * turnRate };
+}
 
+void Ship::UpdateVisuals(float deltaTime)
+{
 	// When yawing and strafing, there's some bank added to the model for visual flavor.
 	float targetVisualBank = (-30 * DEG2RAD * SmoothYawLeft) + (-15 * DEG2RAD * SmoothLeft);
 	VisualBank = SmoothDamp(VisualBank, targetVisualBank, 10, deltaTime);
-	Quaternion visualRotation = QuaternionMultiply(
-		Rotation, QuaternionFromAxisAngle({ 0, 0, 1 }, VisualBank));
 
-	// Sync up the raylib representation of the model with the ship's position so that processing
-	// doesn't have to happen at the render stage.
-	auto transform = MatrixTranslate(Position.x, Position.y, Position.z);
-	transform = MatrixMultiply(QuaternionToMatrix(visualRotation), transform);
-	ShipModel.transform = transform;
+	UpdateModelTransform();
+
+	TrailTime += deltaTime;
+	if (TrailTime > TrailTimeRebase)
+	{
+		TrailTime -= TrailTimeRebase;
+		for (int i = 0; i < TrailRungCount; ++i)
+			Rungs[i].SpawnTime -= TrailTimeRebase;
+	}
 
 	// The currently active trail rung is dragged directly behind the ship for a smoother trail.
 	PositionActiveTrailRung();
 	if (Vector3Distance(Position, LastRungPosition) > RungDistance)
 	{
-		RungIndex = (RungIndex + 1) % RungCount;
+		RungIndex = (RungIndex + 1) % TrailRungCount;
 		LastRungPosition = Position;
 	}
+}
 
-	for (int i = 0; i < RungCount; ++i)
-		Rungs[i].TimeToLive -= deltaTime;
+void Ship::UpdateModelTransform()
+{
+	Quaternion visualRotation = QuaternionMultiply(
+		Rotation, QuaternionFromRotationVector({ 0, 0, VisualBank }));
+
+	// Build the model transform here so that processing doesn't have to happen at the render
+	// stage. It's kept apart from ShipModel since the render thread reads that while this runs.
+	auto transform = QuaternionToMatrix(visualRotation);
+	transform.m12 = Position.x;
+	transform.m13 = Position.y;
+	transform.m14 = Position.z;
+	ModelTransform = transform;
+}
+
+Vector3 Ship::MoveAndCollide(const MeshBVH& world, Vector3 movement)
+{
+	float radius = fmaxf(Length, Width) * .5f;
+
+	// Each iteration moves the ship up to the first surface it hits, then strips the part of the
+	// movement going into that surface so that the rest of it slides along.
+	for (int i = 0; i < MaxCollisionIterations; ++i)
+	{
+		float distance = Vector3Length(movement);
+		if (distance < 1e-5f)
+			return movement;
+
+		auto hit = world.SweepSphere(Position, Vector3Add(Position, movement), radius);
+		if (!hit.Hit)
+			return movement;
+
+		auto direction = Vector3Scale(movement, 1.0f / distance);
+		float travel = fmaxf(hit.Distance - CollisionSkin, 0.0f);
+		Position = Vector3Add(Position, Vector3Scale(direction, travel));
+
+		movement = Vector3Scale(direction, distance - travel);
+		float intoSurface = Vector3DotProduct(movement, hit.Normal);
+		if (intoSurface < 0)
+			movement = Vector3Subtract(movement, Vector3Scale(hit.Normal, intoSurface));
+
+		float velocityIntoSurface = Vector3DotProduct(Velocity, hit.Normal);
+		if (velocityIntoSurface < 0)
+			Velocity = Vector3Subtract(Velocity, Vector3Scale(hit.Normal, velocityIntoSurface));
+	}
+
+	// Out of iterations, so whatever movement is left was never swept. It's dropped rather than
+	// risk pushing the ship into geometry, which can happen in corners where surfaces meet.
+	return Vector3Zero();
 }
 
 void Ship::PositionActiveTrailRung()
 {
-	Rungs[RungIndex].TimeToLive = RungTimeToLive;
+	Rungs[RungIndex].SpawnTime = TrailTime;
 	float halfWidth = Width / 2.f;
 	float halfLength = Length / 2.f;
 	Rungs[RungIndex].LeftPoint = TransformPoint({ -halfWidth, 0.0f, -halfLength });
 	Rungs[RungIndex].RightPoint = TransformPoint({ halfWidth, 0.0f, -halfLength });
 }
 
-void Ship::Draw(bool showDebugAxes) const
+void Ship::WriteSnapshot(ShipSnapshot& snapshot) const
 {
-	DrawModel(ShipModel, Vector3Zero(), 1, ShipColor);
+	snapshot.Position = Position;
+	snapshot.Rotation = Rotation;
+	snapshot.Transform = ModelTransform;
+	snapshot.TrailColor = TrailColor;
+	snapshot.TrailTime = TrailTime;
+	snapshot.RungIndex = RungIndex;
+	for (int i = 0; i < TrailRungCount; ++i)
+		snapshot.Rungs[i] = Rungs[i];
+}
+
+void Ship::WriteState(StateWriter& writer) const
+{
+	// Fields that change every tick are kept together so that deltas between ticks are compact.
+	Actor::WriteState(writer);
+
+	writer.Write(SmoothForward);
+	writer.Write(SmoothLeft);
+	writer.Write(SmoothUp);
+	writer.Write(SmoothPitchDown);
+	writer.Write(SmoothRollRight);
+	writer.Write(SmoothYawLeft);
+	writer.Write(VisualBank);
+
+	writer.Write(TrailTime);
+	writer.Write(Rungs[RungIndex]);
+
+	// Only the active rung moves each tick, so the rest of the trail is left out. The rung after
+	// it is the next one to be overwritten, and is saved so its old position can be put back.
+	writer.Write(RungIndex);
+	writer.Write(LastRungPosition);
+	writer.Write(Rungs[(RungIndex + 1) % TrailRungCount]);
+}
+
+void Ship::ReadState(StateReader& reader)
+{
+	Actor::ReadState(reader);
+
+	reader.Read(SmoothForward);
+	reader.Read(SmoothLeft);
+	reader.Read(SmoothUp);
+	reader.Read(SmoothPitchDown);
+	reader.Read(SmoothRollRight);
+	reader.Read(SmoothYawLeft);
+	reader.Read(VisualBank);
+
+	// Stepping back over a rebase of the trail clock puts the rungs back on the old clock.
+	float trailTime = TrailTime;
+	reader.Read(trailTime);
+	if (trailTime - TrailTime > TrailTimeRebase * .5f)
+	{
+		for (int i = 0; i < TrailRungCount; ++i)
+			Rungs[i].SpawnTime += TrailTimeRebase;
+	}
+	TrailTime = trailTime;
+
+	TrailRung activeRung = Rungs[RungIndex];
+	reader.Read(activeRung);
+	reader.Read(RungIndex);
+	reader.Read(LastRungPosition);
+	reader.Read(Rungs[(RungIndex + 1) % TrailRungCount]);
+	Rungs[RungIndex] = activeRung;
+
+	// Any other rung keeps what it was last given. Going back a tick at a time, that's from the
+	// earliest later tick where it was the next rung, which is from before it was overwritten and
+	// so still what it was at this tick.
+
+	UpdateModelTransform();
+}
+
+void Ship::Draw(const ShipSnapshot& snapshot, bool showDebugAxes) const
+{
+	Model model = ShipModel;
+	model.transform = snapshot.Transform;
+	RenderStats::DrawModel(model, Vector3Zero(), 1, ShipColor);
 
 	if (showDebugAxes)
 	{
-		BeginBlendMode(BlendMode::BLEND_ADDITIVE);
-		DrawLine3D(Position, Vector3Add(Position, GetForward()), { 0, 0, 255, 255 });
-		DrawLine3D(Position, Vector3Add(Position, GetLeft()), { 255, 0, 0, 255 });
-		DrawLine3D(Position, Vector3Add(Position, GetUp()), { 0, 255, 0, 255 });
-		EndBlendMode();
+		auto position = snapshot.Position;
+		auto forward = Vector3RotateByQuaternion({ 0, 0, 1 }, snapshot.Rotation);
+		auto left = Vector3RotateByQuaternion({ 1, 0, 0 }, snapshot.Rotation);
+		auto up = Vector3RotateByQuaternion({ 0, 1, 0 }, snapshot.Rotation);
+
+		RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+		DrawLine3D(position, Vector3Add(position, forward), { 0, 0, 255, 255 });
+		DrawLine3D(position, Vector3Add(position, left), { 255, 0, 0, 255 });
+		DrawLine3D(position, Vector3Add(position, up), { 0, 255, 0, 255 });
+		RenderStats::EndBlendMode();
 	}
 }
 
-void Ship::DrawTrail() const
+void Ship::DrawTrail(const ShipSnapshot& snapshot)
 {
-	BeginBlendMode(BlendMode::BLEND_ADDITIVE);
-	rlDisableDepthMask();
+	auto& rungs = snapshot.Rungs;
 
-	for (int i = 0; i < RungCount; ++i)
+	RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+	RenderStats::SetDepthMask(false);
+
+	for (int i = 0; i < TrailRungCount; ++i)
 	{
-		if (Rungs[i].TimeToLive <= 0)
+		float timeToLive = RungTimeToLive - (snapshot.TrailTime - rungs[i].SpawnTime);
+		if (timeToLive <= 0)
 			continue;
 
-		auto& thisRung = Rungs[i % RungCount];
+		auto& thisRung = rungs[i % TrailRungCount];
 
-		Color color = TrailColor;
-		color.a = 255 * thisRung.TimeToLive / RungTimeToLive;
+		Color color = snapshot.TrailColor;
+		color.a = 255 * timeToLive / RungTimeToLive;
 		Color fill = color;
 		fill.a = color.a / 4;
 
 		// The current rung is dragged along behind the ship, so the crossbar shouldn't be drawn.
 		// If the crossbar is drawn when the ship is slow, it looks weird having a line behind it.
-		if (i != RungIndex)
+		if (i != snapshot.RungIndex)
 			DrawLine3D(thisRung.LeftPoint, thisRung.RightPoint, color);
 
-		auto& nextRung = Rungs[(i + 1) % RungCount];
-		if (nextRung.TimeToLive > 0 && thisRung.TimeToLive < nextRung.TimeToLive)
+		auto& nextRung = rungs[(i + 1) % TrailRungCount];
+		float nextTimeToLive = RungTimeToLive - (snapshot.TrailTime - nextRung.SpawnTime);
+		if (nextTimeToLive > 0 && thisRung.SpawnTime < nextRung.SpawnTime)
 		{
 			DrawLine3D(nextRung.LeftPoint, thisRung.LeftPoint, color);
 			DrawLine3D(nextRung.RightPoint, thisRung.RightPoint, color);
@@ -156,9 +308,9 @@ void Ship::DrawTrail() const
 		}
 	}
 
-	rlDrawRenderBatchActive();
-	rlEnableDepthMask();
-	EndBlendMode();
+	RenderStats::FlushBatch();
+	RenderStats::SetDepthMask(true);
+	RenderStats::EndBlendMode();
 }
 
 Crosshair::Crosshair(const char* modelPath)
@@ -176,17 +328,35 @@ void Crosshair::PositionCrosshairOnShip(const Ship& ship, float distance)
 	auto crosshairPos = Vector3Add(Vector3Scale(ship.GetForward(), distance), ship.Position);
 	auto crosshairTransform = MatrixTranslate(crosshairPos.x, crosshairPos.y, crosshairPos.z);
 	crosshairTransform = MatrixMultiply(QuaternionToMatrix(ship.Rotation), crosshairTransform);
-	CrosshairModel.transform = crosshairTransform;
+	Transform = crosshairTransform;
+}
+
+float Crosshair::PositionCrosshairOnShip(const Ship& ship, float distance, const MeshBVH& world)
+{
+	auto hit = world.Raycast(ship.Position, ship.GetForward(), distance);
+	if (hit.Hit)
+		distance = hit.Distance;
+
+	PositionCrosshairOnShip(ship, distance);
+	return distance;
+}
+
+Matrix Crosshair::GetTransform() const
+{
+	return Transform;
 }
 
-void Crosshair::DrawCrosshair() const
+void Crosshair::DrawCrosshair(Matrix transform) const
 {
-	BeginBlendMode(BlendMode::BLEND_ADDITIVE);
-	rlDisableDepthTest();
+	Model model = CrosshairModel;
+	model.transform = transform;
+
+	RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+	RenderStats::SetDepthTest(false);
 
-	DrawModel(CrosshairModel, Vector3Zero(), 1, DARKGREEN);
+	RenderStats::DrawModel(model, Vector3Zero(), 1, DARKGREEN);
 	//DrawModelWires(Model, Vector3Zero(), 1, DARKGREEN);
 
-	rlEnableDepthTest();
-	EndBlendMode();
+	RenderStats::SetDepthTest(true);
+	RenderStats::EndBlendMode();
 }
@@ -2,11 +2,35 @@
 
 #include "Actor.h"
 
+class MeshBVH;
+class TextureAtlas;
+class StateReader;
+class StateWriter;
+
 struct TrailRung
 {
 	Vector3 LeftPoint;
 	Vector3 RightPoint;
-	float TimeToLive;
+	// Time on the ship's trail clock when the rung was laid down. Rungs store this rather than a
+	// countdown so that they stay unchanged from tick to tick, which keeps rewind deltas small.
+	float SpawnTime;
+};
+
+static const int TrailRungCount = 16;
+
+/// <summary>
+/// Everything needed to draw a ship, copied out of the simulation once per tick so that the
+/// render thread never reads a ship while it's being updated.
+/// </summary>
+struct ShipSnapshot
+{
+	Vector3 Position;
+	Quaternion Rotation;
+	Matrix Transform;
+	Color TrailColor;
+	float TrailTime;
+	int RungIndex;
+	TrailRung Rungs[TrailRungCount];
 };
 
 class Ship : public Actor
@@ -30,19 +54,46 @@ public:
 
 	Color TrailColor = DARKGREEN;
 
-	Ship(const char* modelPath, const char* texturePath, Color color);
+	/// <summary>
+	/// The texture must already be packed into the atlas, which the ship's model then shares.
+	/// </summary>
+	Ship(const char* modelPath, const TextureAtlas& atlas, const char* texturePath, Color color);
 	~Ship();
 
-	void Update(float deltaTime);
-	void Draw(bool showDebugAxes) const;
-	void DrawTrail() const;
+	/// <summary>
+	/// Flies the ship and works out its angular velocity, without turning it yet. When world
+	/// geometry is given, the ship collides with and slides along it.
+	/// </summary>
+	void UpdateMovement(float deltaTime, const MeshBVH* world);
+
+	/// <summary>
+	/// Updates the model transform and trail. Call once the rotation has been integrated.
+	/// </summary>
+	void UpdateVisuals(float deltaTime);
+	void WriteSnapshot(ShipSnapshot& snapshot) const;
+
+	/// <summary>
+	/// Saves or restores everything that affects how the ship flies and looks, apart from the
+	/// pilot's current inputs, which stay live so the ship responds normally after a rewind.
+	/// Only two trail rungs are saved per tick, so restoring has to go back one tick at a time
+	/// for the rest of the trail to come out right.
+	/// </summary>
+	void WriteState(StateWriter& writer) const;
+	void ReadState(StateReader& reader);
+
+	/// <summary>
+	/// Draws this ship's model at the pose captured in the snapshot. Only the model and color are
+	/// read from the ship itself, so this is safe to call while the ship is being updated.
+	/// </summary>
+	void Draw(const ShipSnapshot& snapshot, bool showDebugAxes) const;
+	static void DrawTrail(const ShipSnapshot& snapshot);
 
 private:
 	Model ShipModel = {};
 	Color ShipColor = {};
+	Matrix ModelTransform = {};
 
-	static const int RungCount = 16;
-	TrailRung Rungs[RungCount];
+	TrailRung Rungs[TrailRungCount];
 
 	float SmoothForward = 0;
 	float SmoothLeft = 0;
@@ -54,9 +105,12 @@ private:
 
 	float VisualBank = 0;
 
+	void UpdateModelTransform();
 	void PositionActiveTrailRung();
+	Vector3 MoveAndCollide(const MeshBVH& world, Vector3 movement);
 	Vector3 LastRungPosition = { 0, 0, 0 };
 	int RungIndex = 0;
+	float TrailTime = 0;
 };
 
 class Crosshair
@@ -66,8 +120,17 @@ public:
 	~Crosshair();
 
 	void PositionCrosshairOnShip(const Ship& ship, float distance);
-	void DrawCrosshair() const;
+
+	/// <summary>
+	/// Same as above, but the crosshair is pulled in to sit on whatever the ship is aiming at.
+	/// Returns the distance the crosshair was placed at.
+	/// </summary>
+	float PositionCrosshairOnShip(const Ship& ship, float distance, const MeshBVH& world);
+
+	Matrix GetTransform() const;
+	void DrawCrosshair(Matrix transform) const;
 
 private:
 	Model CrosshairModel = {};
+	Matrix Transform = {};
 };
@@ -0,0 +1,295 @@
+#include "Simulation.h"
+
+#include <raymath.h>
+#include <chrono>
+
+#include "AllocationTracker.h"
+#include "MeshBVH.h"
+#include "StateStream.h"
+
+static const int SimulationRate = 120;
+static const float MaxDeltaTime = 0.1f;
+
+// Input is sampled on its own thread at this rate, independent of the simulation rate.
+static const int InputSampleRate = 1000;
+static const bool SubstepInput = true;
+
+// How far back the rewind buffer reaches. Memory for it is reserved assuming each tick's delta is
+// at most this fraction of the full state. A flying ship changes its motion, smoothed inputs,
+// trail clock and active trail rung every tick, which is nearly all of the 144 bytes it saves.
+static const int RewindSeconds = 5;
+static const float RewindDeltaRatio = 0.85f;
+
+static void ApplyInputToShip(Ship& ship, const ShipInput& input)
+{
+	ship.InputForward = input.Forward;
+	ship.InputLeft = input.Left;
+	ship.InputUp = input.Up;
+	ship.InputPitchDown = input.PitchDown;
+	ship.InputRollRight = input.RollRight;
+	ship.InputYawLeft = input.YawLeft;
+}
+
+Simulation::Simulation(const MeshBVH* world, const TextureAtlas& atlas)
+	: Player("data/ship.gltf", atlas, "data/a16.png", RAYWHITE)
+	, Other("data/ship.gltf", atlas, "data/a16.png", RAYWHITE)
+	, CrosshairNear("data/crosshair2.gltf")
+	, CrosshairFar("data/crosshair2.gltf")
+	, Dust(25, 255)
+	, CameraFlight(true, 50)
+	, Input(InputSampleRate)
+	, History(RewindSeconds * SimulationRate, RewindDeltaRatio)
+{
+	World = world;
+
+	Other.TrailColor = MAROON;
+	Other.Position = { 10, 2, 10 };
+
+	Ships[0] = &Player;
+	Ships[1] = &Other;
+	for (int i = 0; i < ShipCount; ++i)
+		ShipActors[i] = Ships[i];
+
+	Crosshairs[0] = &CrosshairNear;
+	Crosshairs[1] = &CrosshairFar;
+}
+
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+void Simulation::Start()
+{
+	if (Running)
+		return;
+
+	// The first recorded state is the baseline the history is built up from.
+	RecordState();
+
+	// Publish a frame up front so the render thread has something to draw straight away.
+	WriteSnapshot(Frames.GetWriteBuffer());
+	Frames.Publish();
+
+	Input.Start();
+	Running = true;
+	Thread = std::thread(&Simulation::Run, this);
+}
+
+void Simulation::Stop()
+{
+	Running = false;
+	if (Thread.joinable())
+		Thread.join();
+
+	Input.Stop();
+}
+
+void Simulation::SampleInput()
+{
+	Input.SampleOnEventThread();
+}
+
+const FrameSnapshot& Simulation::AcquireFrame()
+{
+	Frames.Acquire();
+	return Frames.GetReadBuffer();
+}
+
+void Simulation::Run()
+{
+	using namespace std::chrono;
+	AllocationScope allocationScope(Subsystem::Simulation);
+
+	const auto period = duration_cast<steady_clock::duration>(duration<double>(1.0 / SimulationRate));
+	auto nextTick = steady_clock::now() + period;
+	double lastTickEnd = GetInputTime();
+
+	while (Running)
+	{
+		std::this_thread::sleep_until(nextTick);
+
+		// After a long stall, carry on from now rather than running a burst of ticks to catch up.
+		auto now = steady_clock::now();
+		nextTick = now - nextTick > period ? now + period : nextTick + period;
+
+		double tickEnd = GetInputTime();
+		float deltaTime = fminf((float)(tickEnd - lastTickEnd), MaxDeltaTime);
+		lastTickEnd = tickEnd;
+
+		Tick(tickEnd, deltaTime);
+		WriteSnapshot(Frames.GetWriteBuffer());
+		Frames.Publish();
+
+		TickMilliseconds = duration<float, std::milli>(steady_clock::now() - now).count();
+	}
+}
+
+void Simulation::Tick(double tickEnd, float deltaTime)
+{
+	// Input and gameplay updates. When sub-stepping, the tick is split at the time each input
+	// event was sampled, so the ships start responding from that point in the tick instead of
+	// from the start of the next one.
+	{
+		double tickStart = tickEnd - deltaTime;
+		float simulated = 0;
+
+		int eventCount = Input.PollEvents(InputEvents, MaxInputEventsPerTick);
+		for (int e = 0; e < eventCount; ++e)
+		{
+			if (SubstepInput && !Rewinding)
+			{
+				float eventOffset = Clamp((float)(InputEvents[e].Time - tickStart), 0, deltaTime);
+				if (eventOffset > simulated)
+				{
+					UpdateShips(eventOffset - simulated);
+					simulated = eventOffset;
+				}
+			}
+
+			for (int i = 0; i < ShipCount; ++i)
+				ApplyInputToShip(*Ships[i], InputEvents[e].Ship);
+
+			// Any part of the tick already simulated before rewind was pressed is never recorded.
+			// Restoring reads the recorded state back over it, so it's simply thrown away.
+			Rewinding = InputEvents[e].Rewind;
+
+			InputDelay.Record(InputEvents[e].Time, GetInputTime());
+		}
+
+		if (Rewinding)
+		{
+			RestoreState();
+		}
+		else
+		{
+			UpdateShips(deltaTime - simulated);
+			RecordState();
+		}
+
+		InputDelay.Update(tickEnd);
+
+		if (World != nullptr)
+		{
+			CrosshairNear.PositionCrosshairOnShip(Player, 10, *World);
+			CrosshairFar.PositionCrosshairOnShip(Player, 30, *World);
+		}
+		else
+		{
+			CrosshairNear.PositionCrosshairOnShip(Player, 10);
+			CrosshairFar.PositionCrosshairOnShip(Player, 30);
+		}
+	}
+
+	// Camera movement and visual effects
+	{
+		CameraFlight.FollowShip(Player, deltaTime);
+		Dust.UpdateViewPosition(CameraFlight.GetPosition());
+	}
+
+	TickCount++;
+}
+
+void Simulation::UpdateShips(float deltaTime)
+{
+	for (int i = 0; i < ShipCount; ++i)
+		Ships[i]->UpdateMovement(deltaTime, World);
+
+	Actor::IntegrateRotations(ShipActors, ShipCount, deltaTime);
+
+	for (int i = 0; i < ShipCount; ++i)
+		Ships[i]->UpdateVisuals(deltaTime);
+}
+
+void Simulation::RecordState()
+{
+	using namespace std::chrono;
+	auto start = steady_clock::now();
+
+	StateWriter writer(StateBuffer);
+	for (int i = 0; i < ShipCount; ++i)
+		Ships[i]->WriteState(writer);
+
+	History.Record(StateBuffer.data(), writer.GetSize());
+
+	RewindMilliseconds = duration<float, std::milli>(steady_clock::now() - start).count();
+}
+
+void Simulation::RestoreState()
+{
+	using namespace std::chrono;
+	auto start = steady_clock::now();
+
+	// Once the history runs out, the ships stay frozen at the oldest state until rewind is let
+	// go, and recording carries on from there.
+	History.StepBack();
+
+	StateReader reader(History.GetState(), History.GetStateSize());
+	for (int i = 0; i < ShipCount; ++i)
+		Ships[i]->ReadState(reader);
+
+	if (reader.HasFailed())
+		TraceLog(LOG_WARNING, "SIMULATION: Rewind state was shorter than expected");
+
+	RewindMilliseconds = duration<float, std::milli>(steady_clock::now() - start).count();
+}
+
+void Simulation::WriteSnapshot(FrameSnapshot& frame) const
+{
+	// Whatever the render thread last read from this frame is finished with by now.
+	frame.Arena.Reset();
+
+	frame.Tick = TickCount;
+	frame.Camera = CameraFlight.GetCamera();
+	frame.PlayerVelocity = Player.Velocity;
+
+	frame.Ships = frame.Arena.AllocateArray<ShipSnapshot>(ShipCount);
+	frame.ShipCount = frame.Ships != nullptr ? ShipCount : 0;
+	for (int i = 0; i < frame.ShipCount; ++i)
+		Ships[i]->WriteSnapshot(frame.Ships[i]);
+
+	frame.Crosshairs = frame.Arena.AllocateArray<Matrix>(CrosshairCount);
+	frame.CrosshairCount = frame.Crosshairs != nullptr ? CrosshairCount : 0;
+	for (int i = 0; i < frame.CrosshairCount; ++i)
+		frame.Crosshairs[i] = Crosshairs[i]->GetTransform();
+
+	auto& dustPoints = Dust.GetPoints();
+	frame.DustPoints = frame.Arena.AllocateArray<Vector3>((int)dustPoints.size());
+	frame.DustCount = frame.DustPoints != nullptr ? (int)dustPoints.size() : 0;
+	for (int i = 0; i < frame.DustCount; ++i)
+		frame.DustPoints[i] = dustPoints[i];
+
+	frame.TickMilliseconds = TickMilliseconds;
+	frame.InputQueueMilliseconds = InputDelay.GetAverageMilliseconds();
+	frame.InputQueueMaxMilliseconds = InputDelay.GetMaxMilliseconds();
+
+	frame.Rewinding = Rewinding;
+	frame.RewindMilliseconds = RewindMilliseconds;
+	frame.RewindTicks = History.GetTickCount();
+	frame.RewindBytes = History.GetUsedBytes();
+}
+
+int Simulation::GetShipCount() const
+{
+	return ShipCount;
+}
+
+const Ship& Simulation::GetShip(int index) const
+{
+	return *Ships[index];
+}
+
+int Simulation::GetCrosshairCount() const
+{
+	return CrosshairCount;
+}
+
+const Crosshair& Simulation::GetCrosshair(int index) const
+{
+	return *Crosshairs[index];
+}
+
+const SpaceDust& Simulation::GetDust() const
+{
+	return Dust;
+}
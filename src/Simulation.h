@@ -0,0 +1,132 @@
+#pragma once
+
+#include <raylib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "FrameArena.h"
+#include "GameCamera.h"
+#include "Input.h"
+#include "RewindBuffer.h"
+#include "Ship.h"
+#include "SpaceDust.h"
+#include "TripleBuffer.h"
+
+class MeshBVH;
+class TextureAtlas;
+
+/// <summary>
+/// Everything the render pass needs from one simulation tick. Once published, a frame is never
+/// modified until the render thread is done with it.
+/// </summary>
+struct FrameSnapshot
+{
+	static const size_t ArenaSize = 64 * 1024;
+
+	// Backs the arrays below. Reset every time the simulation starts writing into this frame.
+	FrameArena Arena = FrameArena(ArenaSize);
+
+	long long Tick = 0;
+
+	Camera3D Camera = {};
+	Vector3 PlayerVelocity = { 0, 0, 0 };
+
+	ShipSnapshot* Ships = nullptr;
+	int ShipCount = 0;
+	Matrix* Crosshairs = nullptr;
+	int CrosshairCount = 0;
+	Vector3* DustPoints = nullptr;
+	int DustCount = 0;
+
+	float TickMilliseconds = 0;
+	float InputQueueMilliseconds = 0;
+	float InputQueueMaxMilliseconds = 0;
+
+	bool Rewinding = false;
+	float RewindMilliseconds = 0;
+	int RewindTicks = 0;
+	size_t RewindBytes = 0;
+};
+
+/// <summary>
+/// Runs the ships, camera and dust on their own thread at a fixed rate, so that simulating and
+/// rendering overlap rather than taking turns. Must be created on the thread that owns the
+/// window, since the ships and crosshairs load their models on construction. The ships' textures
+/// come from the atlas.
+/// </summary>
+class Simulation
+{
+public:
+	Simulation(const MeshBVH* world, const TextureAtlas& atlas);
+	~Simulation();
+
+	void Start();
+	void Stop();
+
+	/// <summary>
+	/// Window thread only. Call once per frame after window events have been polled, for
+	/// platforms where input can't be sampled on its own thread.
+	/// </summary>
+	void SampleInput();
+
+	/// <summary>
+	/// Render thread only. The most recent frame the simulation has finished, which stays
+	/// untouched until the next call.
+	/// </summary>
+	const FrameSnapshot& AcquireFrame();
+
+	/// <summary>
+	/// Objects being simulated, exposed so that the render thread can draw them. Anything that
+	/// changes per tick must be read from the frame snapshot instead.
+	/// </summary>
+	int GetShipCount() const;
+	const Ship& GetShip(int index) const;
+	int GetCrosshairCount() const;
+	const Crosshair& GetCrosshair(int index) const;
+	const SpaceDust& GetDust() const;
+
+private:
+	static const int ShipCount = 2;
+	static const int CrosshairCount = 2;
+	static const int MaxInputEventsPerTick = 256;
+
+	const MeshBVH* World;
+
+	Ship Player;
+	Ship Other;
+	Ship* Ships[ShipCount];
+	Actor* ShipActors[ShipCount];
+
+	Crosshair CrosshairNear;
+	Crosshair CrosshairFar;
+	Crosshair* Crosshairs[CrosshairCount];
+
+	SpaceDust Dust;
+	GameCamera CameraFlight;
+
+	InputSampler Input;
+	InputQueueDelay InputDelay;
+	InputEvent InputEvents[MaxInputEventsPerTick];
+
+	// Serialized ship state from every recent tick. While rewind is held, each tick steps one tick
+	// back through this instead of simulating.
+	RewindBuffer History;
+	std::vector<unsigned char> StateBuffer;
+	bool Rewinding = false;
+	float RewindMilliseconds = 0;
+
+	TripleBuffer<FrameSnapshot> Frames;
+	std::thread Thread;
+	std::atomic<bool> Running = false;
+
+	long long TickCount = 0;
+	float TickMilliseconds = 0;
+
+	void Run();
+	void Tick(double tickEnd, float deltaTime);
+	void UpdateShips(float deltaTime);
+	void RecordState();
+	void RestoreState();
+	void WriteSnapshot(FrameSnapshot& frame) const;
+};
@@ -1,10 +1,11 @@
 #include "SpaceDust.h"
 
 #include <raymath.h>
-#include <rlgl.h>
 #include <cmath>
 #include <array>
 
+#include "RenderStats.h"
+
 inline float GetPrettyBadRandomFloat(float min, float max)
 {
 	auto value = static_cast<float>(GetRandomValue((int)min * 1000, (int)max * 1000));
@@ -59,13 +60,18 @@ void SpaceDust::UpdateViewPosition(Vector3 viewPosition)
 	}
 }
 
-void SpaceDust::Draw(Vector3 viewPosition, Vector3 velocity, bool drawDots) const
+const std::vector<Vector3>& SpaceDust::GetPoints() const
+{
+	return Points;
+}
+
+void SpaceDust::Draw(const Vector3* points, int count, Vector3 viewPosition, Vector3 velocity, bool drawDots) const
 {
-	BeginBlendMode(BlendMode::BLEND_ADDITIVE);
+	RenderStats::BeginBlendMode(BlendMode::BLEND_ADDITIVE);
 
-	for (int i = 0; i < Points.size(); ++i)
+	for (int i = 0; i < count && i < Colors.size(); ++i)
 	{
-		float distance = Vector3Distance(viewPosition, Points[i]);
+		float distance = Vector3Distance(viewPosition, points[i]);
 
 		float farLerp = Clamp(Normalize(distance, Extent * .9f, Extent), 0, 1);
 		unsigned char farAlpha = (unsigned char)Lerp(255, 0, farLerp);
@@ -75,18 +81,18 @@ void SpaceDust::Draw(Vector3 viewPosition, Vector3 velocity, bool drawDots) cons
 		if (drawDots)
 		{
 			DrawSphereWires(
-				Points[i],
+				points[i],
 				cubeSize,
 				2, 4,
 				{ Colors[i].r, Colors[i].g, Colors[i].b, farAlpha });
 		}
 
 		DrawLine3D(
-			Vector3Add(Points[i], Vector3Scale(velocity, 0.02f)),
-			Points[i],
+			Vector3Add(points[i], Vector3Scale(velocity, 0.02f)),
+			points[i],
 			{ Colors[i].r, Colors[i].g, Colors[i].b, farAlpha });
 	}
 
-	rlDrawRenderBatchActive();
-	EndBlendMode();
+	RenderStats::FlushBatch();
+	RenderStats::EndBlendMode();
 }
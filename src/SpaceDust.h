@@ -9,7 +9,13 @@ public:
 	SpaceDust(float size, int count);
 
 	void UpdateViewPosition(Vector3 viewPosition);
-	void Draw(Vector3 viewPosition, Vector3 velocity, bool drawDots) const;
+	const std::vector<Vector3>& GetPoints() const;
+
+	/// <summary>
+	/// Draws a copy of the dust points, as returned by GetPoints(). Dust colors are fixed at
+	/// creation, so this is safe to call while the dust is being updated.
+	/// </summary>
+	void Draw(const Vector3* points, int count, Vector3 viewPosition, Vector3 velocity, bool drawDots) const;
 
 private:
 	std::vector<Vector3> Points;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// Writes simulation state as raw bytes. The buffer keeps its size between uses so that once it
+/// has grown large enough, writing never allocates.
+/// </summary>
+class StateWriter
+{
+public:
+	StateWriter(std::vector<unsigned char>& buffer)
+		: Buffer(buffer)
+	{
+	}
+
+	template <typename T>
+	void Write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "State must be plain data");
+		WriteBytes(&value, sizeof(T));
+	}
+
+	void WriteBytes(const void* data, size_t size)
+	{
+		if (Size + size > Buffer.size())
+			Buffer.resize((Size + size) * 2);
+
+		memcpy(Buffer.data() + Size, data, size);
+		Size += size;
+	}
+
+	size_t GetSize() const
+	{
+		return Size;
+	}
+
+private:
+	std::vector<unsigned char>& Buffer;
+	size_t Size = 0;
+};
+
+/// <summary>
+/// Reads back state written by StateWriter. Reading past the end leaves values untouched and
+/// marks the reader as failed.
+/// </summary>
+class StateReader
+{
+public:
+	StateReader(const unsigned char* data, size_t size)
+		: Data(data)
+		, Size(size)
+	{
+	}
+
+	template <typename T>
+	void Read(T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "State must be plain data");
+		ReadBytes(&value, sizeof(T));
+	}
+
+	void ReadBytes(void* data, size_t size)
+	{
+		if (Cursor + size > Size)
+		{
+			Failed = true;
+			return;
+		}
+
+		memcpy(data, Data + Cursor, size);
+		Cursor += size;
+	}
+
+	bool HasFailed() const
+	{
+		return Failed;
+	}
+
+private:
+	const unsigned char* Data;
+	size_t Size;
+	size_t Cursor = 0;
+	bool Failed = false;
+};
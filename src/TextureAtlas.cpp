@@ -0,0 +1,575 @@
+#include "TextureAtlas.h"
+
+#include <rlgl.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+// Edge texels are repeated this far around each source. One texel is enough for coordinates
+// landing right on the far edge of a source, and for bilinear filtering's half texel reach.
+// Filtered mip levels reach twice as far with each level, so they get enough padding to stay
+// within the source down to mip level 2.
+static const int Padding = 1;
+static const int FilteredMipmapPadding = 4;
+static const int MaxAtlasSize = 4096;
+
+// Texture coordinates can be slightly outside 0-1 from exporter rounding without the texture
+// actually being meant to repeat.
+static const float TexcoordTolerance = 0.001f;
+
+static const int BytesPerPixel = 4;
+static const int DXT1BlockBytes = 8;
+
+static const char CacheMagic[4] = { 'E', 'A', 'T', 'L' };
+static const int CacheVersion = 2;
+
+struct CacheHeader
+{
+	char Magic[4];
+	int Version;
+	int Mipmaps;
+	int Compress;
+	int Padding;
+	int SourceCount;
+	int Size;
+	int MipmapCount;
+	int Format;
+	int DataSize;
+};
+
+struct CacheSource
+{
+	long ModTime;
+	AtlasRegion Region;
+};
+
+static int GetPadding(AtlasOptions options)
+{
+	// Point sampling never reads past the texel under the coordinate, and cells stay aligned to
+	// their size in every mip level, so only filtered mipmaps need more.
+	bool filtered = options.Filter != TEXTURE_FILTER_POINT;
+	return options.Mipmaps && filtered ? FilteredMipmapPadding : Padding;
+}
+
+static int NextPowerOfTwo(int value)
+{
+	int result = 1;
+	while (result < value)
+		result *= 2;
+	return result;
+}
+
+static int AlignUp(int value, int alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static unsigned short ToRGB565(const unsigned char* color)
+{
+	return (unsigned short)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void FromRGB565(unsigned short packed, int* color)
+{
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 3);
+}
+
+// Compresses one 4x4 block of an RGBA level to DXT1. Endpoints are the corners of the block's
+// color bounding box, which is quick and good enough for flat, low detail textures. Blocks
+// hanging off the edge of levels smaller than 4x4 repeat the edge texels.
+static void EncodeDXT1Block(const unsigned char* level, int size, int blockX, int blockY, unsigned char* out)
+{
+	unsigned char texels[16][4];
+	unsigned char minColor[3] = { 255, 255, 255 };
+	unsigned char maxColor[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i)
+	{
+		int x = std::min(blockX * 4 + i % 4, size - 1);
+		int y = std::min(blockY * 4 + i / 4, size - 1);
+		memcpy(texels[i], level + (y * size + x) * BytesPerPixel, BytesPerPixel);
+		for (int c = 0; c < 3; ++c)
+		{
+			minColor[c] = std::min(minColor[c], texels[i][c]);
+			maxColor[c] = std::max(maxColor[c], texels[i][c]);
+		}
+	}
+
+	// The first endpoint has to be the larger one for the block to use four colors.
+	unsigned short color0 = ToRGB565(maxColor);
+	unsigned short color1 = ToRGB565(minColor);
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	int palette[4][3];
+	FromRGB565(color0, palette[0]);
+	FromRGB565(color1, palette[1]);
+	for (int c = 0; c < 3; ++c)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	// With equal endpoints the block is in three color mode, where index 0 is still color0.
+	unsigned int indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+			int bestDistance = INT_MAX;
+			for (int p = 0; p < 4; ++p)
+			{
+				int dr = texels[i][0] - palette[p][0];
+				int dg = texels[i][1] - palette[p][1];
+				int db = texels[i][2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance)
+				{
+					best = p;
+					bestDistance = distance;
+				}
+			}
+			indices |= best << (i * 2);
+		}
+	}
+
+	out[0] = color0 & 0xFF;
+	out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF;
+	out[3] = color1 >> 8;
+	out[4] = indices & 0xFF;
+	out[5] = (indices >> 8) & 0xFF;
+	out[6] = (indices >> 16) & 0xFF;
+	out[7] = indices >> 24;
+}
+
+void TextureAtlas::Add(const char* texturePath)
+{
+	Sources.push_back({ texturePath, 0, {} });
+}
+
+bool TextureAtlas::LoadOrBuild(const char* cachePath, AtlasOptions options)
+{
+	if (Sources.empty())
+		return false;
+
+	for (auto& source : Sources)
+		source.ModTime = GetFileModTime(source.Path.c_str());
+
+	if (LoadCache(cachePath, options))
+	{
+		TraceLog(LOG_INFO, "ATLAS: [%s] Loaded %d textures (%dx%d, %d mipmaps) from cache",
+			cachePath, (int)Sources.size(), Size, Size, Mipmaps);
+	}
+	else
+	{
+		if (!Build(options))
+			return false;
+
+		SaveCache(cachePath, options);
+		TraceLog(LOG_INFO, "ATLAS: [%s] Packed %d textures (%dx%d, %d mipmaps)",
+			cachePath, (int)Sources.size(), Size, Size, Mipmaps);
+	}
+
+	if (!Upload() && options.Compress)
+	{
+		TraceLog(LOG_WARNING, "ATLAS: [%s] DXT1 not supported, falling back to uncompressed", cachePath);
+		options.Compress = false;
+		if (Build(options))
+			Upload();
+	}
+
+	Pixels.clear();
+	Pixels.shrink_to_fit();
+
+	if (Texture.id == 0)
+		return false;
+
+	SetTextureFilter(Texture, options.Filter);
+	SetTextureWrap(Texture, TEXTURE_WRAP_CLAMP);
+	return true;
+}
+
+bool TextureAtlas::Build(AtlasOptions options)
+{
+	int sourceCount = (int)Sources.size();
+	int padding = GetPadding(options);
+	std::vector<Image> images(sourceCount);
+	std::vector<int> cellWidths(sourceCount);
+	std::vector<int> cellHeights(sourceCount);
+	std::vector<int> order(sourceCount);
+
+	bool loaded = true;
+	int minSize = 1;
+	int area = 0;
+	for (int i = 0; i < sourceCount; ++i)
+	{
+		images[i] = LoadImage(Sources[i].Path.c_str());
+		if (images[i].data == nullptr)
+		{
+			TraceLog(LOG_WARNING, "ATLAS: [%s] Failed to load texture", Sources[i].Path.c_str());
+			loaded = false;
+			continue;
+		}
+
+		ImageFormat(&images[i], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+		cellWidths[i] = NextPowerOfTwo(images[i].width + padding * 2);
+		cellHeights[i] = NextPowerOfTwo(images[i].height + padding * 2);
+		minSize = std::max(minSize, std::max(cellWidths[i], cellHeights[i]));
+		area += cellWidths[i] * cellHeights[i];
+		order[i] = i;
+	}
+
+	// Shelf packing, tallest cells first. Shelves then only ever get shorter, and since every
+	// height is a power of two, each shelf starts at a multiple of the cells on it.
+	std::sort(order.begin(), order.end(), [&](int a, int b)
+	{
+		if (cellHeights[a] != cellHeights[b])
+			return cellHeights[a] > cellHeights[b];
+		return cellWidths[a] > cellWidths[b];
+	});
+
+	std::vector<int> cellX(sourceCount);
+	std::vector<int> cellY(sourceCount);
+	int size = std::max(minSize, NextPowerOfTwo((int)ceilf(sqrtf((float)area))));
+	bool packed = false;
+	while (loaded && !packed && size <= MaxAtlasSize)
+	{
+		int x = 0;
+		int y = 0;
+		int shelfHeight = 0;
+		packed = true;
+		for (int i : order)
+		{
+			x = AlignUp(x, cellWidths[i]);
+			if (x + cellWidths[i] > size)
+			{
+				y += shelfHeight;
+				x = 0;
+				shelfHeight = 0;
+			}
+
+			if (y + cellHeights[i] > size)
+			{
+				packed = false;
+				size *= 2;
+				break;
+			}
+
+			cellX[i] = x;
+			cellY[i] = y;
+			x += cellWidths[i];
+			shelfHeight = std::max(shelfHeight, cellHeights[i]);
+		}
+	}
+
+	if (loaded && !packed)
+		TraceLog(LOG_WARNING, "ATLAS: Textures don't fit in %dx%d", MaxAtlasSize, MaxAtlasSize);
+
+	if (!loaded || !packed)
+	{
+		for (auto& image : images)
+			UnloadImage(image);
+		return false;
+	}
+
+	Size = size;
+	Mipmaps = options.Mipmaps ? (int)log2f((float)size) + 1 : 1;
+
+	size_t rgbaSize = 0;
+	for (int level = 0, levelSize = size; level < Mipmaps; ++level, levelSize /= 2)
+		rgbaSize += (size_t)levelSize * levelSize * BytesPerPixel;
+
+	std::vector<unsigned char> rgba(rgbaSize, 0);
+
+	// Fill each source's whole cell, clamping to its edges beyond the source itself.
+	for (int i = 0; i < sourceCount; ++i)
+	{
+		const auto& image = images[i];
+		auto source = static_cast<const unsigned char*>(image.data);
+		for (int y = 0; y < cellHeights[i]; ++y)
+		{
+			int sourceY = std::clamp(y - padding, 0, image.height - 1);
+			for (int x = 0; x < cellWidths[i]; ++x)
+			{
+				int sourceX = std::clamp(x - padding, 0, image.width - 1);
+				memcpy(&rgba[((size_t)(cellY[i] + y) * size + cellX[i] + x) * BytesPerPixel],
+					&source[((size_t)sourceY * image.width + sourceX) * BytesPerPixel], BytesPerPixel);
+			}
+		}
+
+		Sources[i].Region = { cellX[i] + padding, cellY[i] + padding, image.width, image.height };
+		UnloadImage(image);
+	}
+
+	// Box filtered mip chain. Cells are aligned to their own size, so a 2x2 footprint never
+	// straddles two cells.
+	size_t levelOffset = 0;
+	for (int level = 1, levelSize = size / 2; level < Mipmaps; ++level, levelSize /= 2)
+	{
+		const unsigned char* previous = &rgba[levelOffset];
+		levelOffset += (size_t)levelSize * 2 * levelSize * 2 * BytesPerPixel;
+		unsigned char* current = &rgba[levelOffset];
+
+		int previousSize = levelSize * 2;
+		for (int y = 0; y < levelSize; ++y)
+		{
+			for (int x = 0; x < levelSize; ++x)
+			{
+				const unsigned char* topLeft = previous + ((size_t)y * 2 * previousSize + x * 2) * BytesPerPixel;
+				const unsigned char* bottomLeft = topLeft + (size_t)previousSize * BytesPerPixel;
+				for (int c = 0; c < BytesPerPixel; ++c)
+				{
+					int sum = topLeft[c] + topLeft[c + BytesPerPixel] + bottomLeft[c] + bottomLeft[c + BytesPerPixel];
+					current[((size_t)y * levelSize + x) * BytesPerPixel + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	if (!options.Compress)
+	{
+		Format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+		Pixels = std::move(rgba);
+		return true;
+	}
+
+	// Matches how raylib sizes compressed levels, where anything under 4x4 still takes a block.
+	Format = PIXELFORMAT_COMPRESSED_DXT1_RGB;
+	Pixels.clear();
+	levelOffset = 0;
+	for (int level = 0, levelSize = size; level < Mipmaps; ++level, levelSize /= 2)
+	{
+		int blocks = std::max(1, levelSize / 4);
+		size_t outOffset = Pixels.size();
+		Pixels.resize(outOffset + (size_t)blocks * blocks * DXT1BlockBytes);
+
+		for (int blockY = 0; blockY < blocks; ++blockY)
+		{
+			for (int blockX = 0; blockX < blocks; ++blockX)
+			{
+				EncodeDXT1Block(&rgba[levelOffset], levelSize, blockX, blockY,
+					&Pixels[outOffset + ((size_t)blockY * blocks + blockX) * DXT1BlockBytes]);
+			}
+		}
+
+		levelOffset += (size_t)levelSize * levelSize * BytesPerPixel;
+	}
+
+	return true;
+}
+
+bool TextureAtlas::Upload()
+{
+	if (Pixels.empty())
+		return false;
+
+	if (Texture.id != 0)
+		UnloadTexture(Texture);
+
+	Image image = {};
+	image.data = Pixels.data();
+	image.width = Size;
+	image.height = Size;
+	image.mipmaps = Mipmaps;
+	image.format = Format;
+
+	// raylib copies the data to the GPU, so the image doesn't need unloading.
+	Texture = LoadTextureFromImage(image);
+	return Texture.id != 0;
+}
+
+bool TextureAtlas::LoadCache(const char* cachePath, AtlasOptions options)
+{
+	if (!FileExists(cachePath))
+		return false;
+
+	unsigned int size = 0;
+	unsigned char* data = LoadFileData(cachePath, &size);
+	if (data == nullptr)
+		return false;
+
+	bool valid = false;
+	CacheHeader header;
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+		size_t expectedSize = sizeof(header)
+			+ header.SourceCount * sizeof(CacheSource)
+			+ header.DataSize;
+
+		valid = memcmp(header.Magic, CacheMagic, sizeof(CacheMagic)) == 0
+			&& header.Version == CacheVersion
+			&& header.Mipmaps == (int)options.Mipmaps
+			&& header.Compress == (int)options.Compress
+			&& header.Padding == GetPadding(options)
+			&& header.SourceCount == (int)Sources.size()
+			&& header.Size > 0
+			&& header.DataSize > 0
+			&& size == expectedSize;
+	}
+
+	auto cursor = data + sizeof(header);
+	for (int i = 0; valid && i < (int)Sources.size(); ++i)
+	{
+		CacheSource source;
+		memcpy(&source, cursor + i * sizeof(CacheSource), sizeof(CacheSource));
+		valid = source.ModTime == Sources[i].ModTime;
+	}
+
+	if (valid)
+	{
+		for (int i = 0; i < (int)Sources.size(); ++i)
+		{
+			CacheSource source;
+			memcpy(&source, cursor, sizeof(CacheSource));
+			Sources[i].Region = source.Region;
+			cursor += sizeof(CacheSource);
+		}
+
+		Size = header.Size;
+		Mipmaps = header.MipmapCount;
+		Format = header.Format;
+		Pixels.assign(cursor, cursor + header.DataSize);
+	}
+
+	UnloadFileData(data);
+	return valid;
+}
+
+void TextureAtlas::SaveCache(const char* cachePath, AtlasOptions options) const
+{
+	if (Pixels.empty())
+		return;
+
+	CacheHeader header;
+	memcpy(header.Magic, CacheMagic, sizeof(CacheMagic));
+	header.Version = CacheVersion;
+	header.Mipmaps = (int)options.Mipmaps;
+	header.Compress = (int)options.Compress;
+	header.Padding = GetPadding(options);
+	header.SourceCount = (int)Sources.size();
+	header.Size = Size;
+	header.MipmapCount = Mipmaps;
+	header.Format = Format;
+	header.DataSize = (int)Pixels.size();
+
+	std::vector<unsigned char> data(sizeof(header)
+		+ Sources.size() * sizeof(CacheSource)
+		+ Pixels.size());
+	auto cursor = data.data();
+	memcpy(cursor, &header, sizeof(header));
+	cursor += sizeof(header);
+	for (const auto& source : Sources)
+	{
+		CacheSource cached = { source.ModTime, source.Region };
+		memcpy(cursor, &cached, sizeof(cached));
+		cursor += sizeof(cached);
+	}
+	memcpy(cursor, Pixels.data(), Pixels.size());
+
+	if (!SaveFileData(cachePath, data.data(), (unsigned int)data.size()))
+		TraceLog(LOG_WARNING, "ATLAS: [%s] Failed to write cache", cachePath);
+}
+
+bool TextureAtlas::ApplyToModel(Model& model, const char* texturePath) const
+{
+	int index = GetRegionIndex(texturePath);
+	if (index < 0 || Texture.id == 0)
+	{
+		TraceLog(LOG_WARNING, "ATLAS: [%s] Texture isn't in the atlas", texturePath);
+		return false;
+	}
+
+	// An atlas region can't repeat, so check every coordinate before touching any of them.
+	for (int m = 0; m < model.meshCount; ++m)
+	{
+		const auto& mesh = model.meshes[m];
+		if (mesh.texcoords == nullptr)
+			continue;
+
+		for (int i = 0; i < mesh.vertexCount * 2; ++i)
+		{
+			float texcoord = mesh.texcoords[i];
+			if (texcoord < -TexcoordTolerance || texcoord > 1 + TexcoordTolerance)
+			{
+				TraceLog(LOG_WARNING, "ATLAS: [%s] Model texture coordinates repeat, can't use the atlas", texturePath);
+				return false;
+			}
+		}
+	}
+
+	const auto& region = Sources[index].Region;
+	float scaleU = (float)region.Width / Size;
+	float scaleV = (float)region.Height / Size;
+	float offsetU = (float)region.X / Size;
+	float offsetV = (float)region.Y / Size;
+
+	for (int m = 0; m < model.meshCount; ++m)
+	{
+		auto& mesh = model.meshes[m];
+		if (mesh.texcoords == nullptr)
+			continue;
+
+		for (int i = 0; i < mesh.vertexCount; ++i)
+		{
+			mesh.texcoords[i * 2] = offsetU + std::clamp(mesh.texcoords[i * 2], 0.0f, 1.0f) * scaleU;
+			mesh.texcoords[i * 2 + 1] = offsetV + std::clamp(mesh.texcoords[i * 2 + 1], 0.0f, 1.0f) * scaleV;
+		}
+
+		// Buffer 1 is texture coordinates.
+		UpdateMeshBuffer(mesh, 1, mesh.texcoords, mesh.vertexCount * 2 * (int)sizeof(float), 0);
+	}
+
+	// Textures the model loaded for itself are no longer used. raylib's UnloadModel() leaves
+	// textures alone, so they'd otherwise never be freed.
+	for (int m = 0; m < model.materialCount; ++m)
+	{
+		auto& texture = model.materials[m].maps[MATERIAL_MAP_ALBEDO].texture;
+		Texture2D previous = texture;
+		texture = Texture;
+
+		if (previous.id == Texture.id || previous.id == rlGetTextureIdDefault())
+			continue;
+
+		// Materials can share a texture, so it's only unloaded once the last of them has moved over.
+		bool stillUsed = false;
+		for (int other = m + 1; other < model.materialCount; ++other)
+			stillUsed |= model.materials[other].maps[MATERIAL_MAP_ALBEDO].texture.id == previous.id;
+
+		if (!stillUsed)
+			UnloadTexture(previous);
+	}
+
+	return true;
+}
+
+void TextureAtlas::Unload()
+{
+	if (Texture.id == 0)
+		return;
+
+	UnloadTexture(Texture);
+	Texture = {};
+}
+
+Texture2D TextureAtlas::GetTexture() const
+{
+	return Texture;
+}
+
+int TextureAtlas::GetRegionIndex(const char* texturePath) const
+{
+	for (int i = 0; i < (int)Sources.size(); ++i)
+	{
+		if (Sources[i].Path == texturePath)
+			return i;
+	}
+	return -1;
+}
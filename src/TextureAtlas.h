@@ -0,0 +1,93 @@
+#pragma once
+
+#include <raylib.h>
+#include <string>
+#include <vector>
+
+struct AtlasOptions
+{
+	// Builds the full chain of mip levels down to 1x1. Each level averages the one above, which
+	// blends neighboring palette colors together, so leave this off for the pixel art look. Turn it
+	// on to stop distant surfaces shimmering.
+	bool Mipmaps = false;
+
+	// Stores the atlas as DXT1. Takes an eighth of the memory of RGBA, but every 4x4 block is
+	// reduced to 4 colors and alpha is dropped, so it's not suited to palette textures. Falls
+	// back to uncompressed if the GPU can't sample DXT1.
+	bool Compress = false;
+
+	// Sampler filter. TEXTURE_FILTER_POINT keeps texels sharp up close. With mipmaps it still picks
+	// a level by distance, so far away surfaces show the blended colors of the smaller levels.
+	// Other filters with mipmaps need each source padded by 4 texels rather than 1.
+	int Filter = TEXTURE_FILTER_POINT;
+};
+
+struct AtlasRegion
+{
+	// Placement of the source texture within the atlas, in texels.
+	int X;
+	int Y;
+	int Width;
+	int Height;
+};
+
+/// <summary>
+/// Packs small textures into a single square texture so that models can share it. Each source
+/// texture gets its own power of two cell, aligned to its size and padded out by repeating its
+/// edges. That keeps each cell separate in every mip level, so sources never bleed into each
+/// other until the cell itself is smaller than a texel.
+/// </summary>
+class TextureAtlas
+{
+public:
+	/// <summary>
+	/// Queues a texture to go in the atlas. Call before LoadOrBuild().
+	/// </summary>
+	void Add(const char* texturePath);
+
+	/// <summary>
+	/// Loads the packed atlas from the cache file. If the cache is missing, was built with
+	/// different options, or is older than any of the source textures, the atlas is packed again
+	/// and the cache is rewritten. The atlas is then uploaded to the GPU.
+	/// </summary>
+	bool LoadOrBuild(const char* cachePath, AtlasOptions options);
+
+	/// <summary>
+	/// Points every mesh of the model at the atlas, moving its texture coordinates into the
+	/// region of the given source texture. Returns false and leaves the model untouched if the
+	/// texture isn't in the atlas, or if the model relies on its texture repeating.
+	/// </summary>
+	bool ApplyToModel(Model& model, const char* texturePath) const;
+
+	/// <summary>
+	/// Frees the atlas texture. Models it was applied to must not be drawn afterwards. Call
+	/// before CloseWindow(), since the texture can't be freed once the GL context is gone.
+	/// </summary>
+	void Unload();
+
+	Texture2D GetTexture() const;
+
+private:
+	struct Source
+	{
+		std::string Path;
+		long ModTime;
+		AtlasRegion Region;
+	};
+
+	std::vector<Source> Sources;
+	int Size = 0;
+	int Mipmaps = 0;
+	int Format = 0;
+
+	// Every mip level back to back, only kept until the atlas has been uploaded.
+	std::vector<unsigned char> Pixels;
+
+	Texture2D Texture = {};
+
+	int GetRegionIndex(const char* texturePath) const;
+	bool Build(AtlasOptions options);
+	bool Upload();
+	bool LoadCache(const char* cachePath, AtlasOptions options);
+	void SaveCache(const char* cachePath, AtlasOptions options) const;
+};
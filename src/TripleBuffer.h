@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+
+/// <summary>
+/// Hands frames from one writer thread to one reader thread without either ever waiting on the
+/// other. The writer always has a buffer of its own to fill, the reader always has a complete
+/// buffer to read, and the third is swapped between them.
+/// </summary>
+template <typename T>
+class TripleBuffer
+{
+public:
+	/// <summary>
+	/// Writer side. The buffer to fill in for the next frame.
+	/// </summary>
+	T& GetWriteBuffer()
+	{
+		return Buffers[WriteIndex];
+	}
+
+	/// <summary>
+	/// Writer side. Hands the write buffer over to the reader. The writer gets the spare buffer
+	/// back, which may hold an older frame that must be fully overwritten.
+	/// </summary>
+	void Publish()
+	{
+		int previous = Shared.exchange(WriteIndex | FreshBit, std::memory_order_acq_rel);
+		WriteIndex = previous & IndexMask;
+	}
+
+	/// <summary>
+	/// Reader side. Swaps in the most recently published buffer if there's been one since the
+	/// last call. Returns whether the read buffer changed.
+	/// </summary>
+	bool Acquire()
+	{
+		if ((Shared.load(std::memory_order_relaxed) & FreshBit) == 0)
+			return false;
+
+		int previous = Shared.exchange(ReadIndex, std::memory_order_acq_rel);
+		ReadIndex = previous & IndexMask;
+		return true;
+	}
+
+	/// <summary>
+	/// Reader side. Stays valid and unchanged until the next call to Acquire().
+	/// </summary>
+	const T& GetReadBuffer() const
+	{
+		return Buffers[ReadIndex];
+	}
+
+private:
+	static const int IndexMask = 3;
+	static const int FreshBit = 4;
+
+	T Buffers[3];
+	int WriteIndex = 0;
+	int ReadIndex = 1;
+	std::atomic<int> Shared = 2;
+};